@@ -23,13 +23,87 @@
  Get AirTurn Interface Version
  */
 - (void)initAirTurn:(CDVInvokedUrlCommand*)command;
+- (void)getStartupProfile:(CDVInvokedUrlCommand*)command;
 - (void)setting:(CDVInvokedUrlCommand*)command;
 - (void)killApp:(CDVInvokedUrlCommand*)command;
 - (void)isConnected:(CDVInvokedUrlCommand*)command;
 - (void)getInfo:(CDVInvokedUrlCommand*)command;
+- (void)getSnapshot:(CDVInvokedUrlCommand*)command;
+- (void)setEventCoalescing:(CDVInvokedUrlCommand*)command;
+- (void)setRepeatCoalescing:(CDVInvokedUrlCommand*)command;
+- (void)runBenchmark:(CDVInvokedUrlCommand*)command;
+- (void)getLatencyStats:(CDVInvokedUrlCommand*)command;
+- (void)resetLatencyStats:(CDVInvokedUrlCommand*)command;
+- (void)getCommandStats:(CDVInvokedUrlCommand*)command;
+- (void)resetCommandStats:(CDVInvokedUrlCommand*)command;
+- (void)setLatencyTracking:(CDVInvokedUrlCommand*)command;
+- (void)reportLatency:(CDVInvokedUrlCommand*)command;
+- (void)ackEvents:(CDVInvokedUrlCommand*)command;
+- (void)getQueueStats:(CDVInvokedUrlCommand*)command;
+
+- (void)openEventStream:(CDVInvokedUrlCommand*)command;
+- (void)closeEventStream:(CDVInvokedUrlCommand*)command;
+- (void)setProcessingMode:(CDVInvokedUrlCommand*)command;
+- (void)setEventDelivery:(CDVInvokedUrlCommand*)command;
+- (void)startAnalogStream:(CDVInvokedUrlCommand*)command;
+- (void)stopAnalogStream:(CDVInvokedUrlCommand*)command;
+- (void)startGestures:(CDVInvokedUrlCommand*)command;
+- (void)stopGestures:(CDVInvokedUrlCommand*)command;
+- (void)startResponderWatchdog:(CDVInvokedUrlCommand*)command;
+- (void)stopResponderWatchdog:(CDVInvokedUrlCommand*)command;
+- (void)setTextEditing:(CDVInvokedUrlCommand*)command;
+- (void)getResponderWatchdogStats:(CDVInvokedUrlCommand*)command;
+- (void)startRecording:(CDVInvokedUrlCommand*)command;
+- (void)stopRecording:(CDVInvokedUrlCommand*)command;
+- (void)replaySession:(CDVInvokedUrlCommand*)command;
 
 - (void)addEventListener:(CDVInvokedUrlCommand*)command;
 - (void)removeEventListener:(CDVInvokedUrlCommand*)command;
+- (void)listSubscriptions:(CDVInvokedUrlCommand*)command;
 
 @property (nonatomic,strong) NSMutableDictionary *observerMap;
+
+/*
+ The center AirTurn notifications are observed on. Default is the default
+ center; set it before adding listeners.
+ */
+@property (nonatomic,strong) NSNotificationCenter *notificationCenter;
+
+/*
+ Serial queue all notification handling (filtering, persistence, encoding)
+ runs on. Only the final bridge hand-off hops to the main queue.
+ */
+@property (nonatomic,strong,readonly) dispatch_queue_t processingQueue;
+@property (nonatomic,strong,readonly) NSOperationQueue *notificationQueue;
+
+/*
+ Whether the processing queue runs on the main thread instead of in the
+ background. Fixed when the queue is created: NO, or the
+ AirTurnProcessEventsOnMainQueue preference, until setProcessingMode swaps in
+ a new queue at the next page load.
+ */
+@property (nonatomic,readonly) BOOL processOnMainQueue;
+
+/*
+ Send every event still waiting for its batch window, folded repeats
+ included, now. Must be called on the processing queue.
+ */
+- (void)flushEvents;
+
+/*
+ Whether the WebView can call page functions with typed arguments
+ (callAsyncJavaScript: a WKWebView on iOS 14 or later).
+ */
+@property (nonatomic,readonly) BOOL canCallPageFunctions;
+
+/*
+ Call a function body in the page with arguments, on the main thread.
+ Returns NO, having done nothing, where canCallPageFunctions is NO. Otherwise
+ completionHandler, if given, is called on the main thread once the body has
+ run, with the error if it threw.
+ */
+- (BOOL)callPageFunction:(NSString *)body arguments:(NSDictionary *)arguments completionHandler:(void (^)(NSError *error))completionHandler;
+
+- (void)observeEventName:(NSString *)eventName;
+- (void)stopObservingEventName:(NSString *)eventName;
 @end
@@ -12,23 +12,90 @@
 #import "AirTurn.h"
 #import "CocoaLumberjack.h"
 #import "AirTurnUIConnectionController.h"
+#import "AirTurnEventQueue.h"
+#import "AirTurnLatencyStats.h"
+#import "AirTurnCommandTimings.h"
+#import "AirTurnStartupProfile.h"
+#import "AirTurnReconnector.h"
+#import "AirTurnResponderWatchdog.h"
+#import "AirTurnPeripheralInfoCache.h"
+#import "AirTurnSnapshotStore.h"
+#import "AirTurnAnalogStreamer.h"
+#import "AirTurnGestureEngine.h"
+#import "AirTurnRepeatCoalescer.h"
+#import "AirTurnSessionRecorder.h"
+#import "AirTurnSessionReplayer.h"
+#import "AirTurnEncoderBenchmark.h"
+#import "AirTurnProcessingBenchmark.h"
+#import "AirTurnLoadGenerator.h"
+#import "AirTurnDeliveryBenchmark.h"
+#import <WebKit/WebKit.h>
 
 #if AirTurnPlayPauseiPod
 @import MediaPlayer;
 #endif
 
-static inline void throwWithName( NSError *error, NSString* name )
-{
-    if (error) {
-        @throw [NSException exceptionWithName:name
-                                       reason:error.debugDescription
-                                     userInfo:@{ @"NSError" : error }];
-    }
-}
+static NSString * const EventCoalescingIntervalPreference = @"AirTurnEventCoalescingInterval";
+static NSString * const ProcessEventsOnMainQueuePreference = @"AirTurnProcessEventsOnMainQueue";
+static NSString * const RepeatCoalescingIntervalPreference = @"AirTurnRepeatCoalescingInterval";
+static NSString * const EventHighWaterMarkPreference = @"AirTurnEventHighWaterMark";
+static NSString * const EventDeliveryPreference = @"AirTurnEventDelivery";
+static NSString * const PrewarmSettingsPreference = @"AirTurnPrewarmSettings";
+
+// posted to ourselves when the main run loop is idle, to build the settings UI ahead of use
+static NSString * const SettingsPrewarmNotification = @"AirTurnSettingsPrewarmNotification";
 
-@interface AirTurn()
+// installed by airturn.js, called with the batch as a string argument rather than as source to compile
+static NSString * const DirectDeliveryFunctionBody = @"window.airturn._deliver(batch, sentAt);";
+
+// pushed to airturn.js so it can answer status queries without a round trip
+static NSString * const StatusEventName = @"AirTurnStatus";
+
+typedef NS_ENUM(NSInteger, AirTurnInitState) {
+    AirTurnInitStateNone = 0,
+    AirTurnInitStateStarting,
+    AirTurnInitStateReady
+};
+
+@interface AirTurn() <AirTurnEventQueueDelegate>
 
 @property (retain) NSString* callbackId;
+@property (nonatomic,strong) AirTurnEventQueue *eventQueue;
+@property (nonatomic,strong) AirTurnSnapshotStore *snapshotStore;
+@property (nonatomic,strong) AirTurnAnalogStreamer *analogStreamer;
+@property (nonatomic,strong) AirTurnGestureEngine *gestureEngine;
+@property (nonatomic,strong) AirTurnRepeatCoalescer *repeatCoalescer;
+@property (nonatomic,strong) AirTurnSessionRecorder *sessionRecorder;
+@property (nonatomic,strong) AirTurnLatencyStats *latencyStats;
+// main queue only
+@property (nonatomic,assign) AirTurnInitState initState;
+@property (nonatomic,strong) NSMutableArray<NSString *> *initCallbackIds;
+@property (nonatomic,strong) AirTurnStartupProfile *startupProfile;
+@property (nonatomic,strong) AirTurnResponderWatchdog *responderWatchdog;
+// JS subscribers per event name, observed while above zero. Guarded, with observerMap, by @synchronized(self).
+@property (nonatomic,strong) NSCountedSet<NSString *> *subscriptions;
+@property (nonatomic,strong) id centralStateObserver;
+@property (nonatomic,strong) NSMutableArray *statusObservers;
+// what airturn.js was last sent, nil and 0 until the first push
+@property (nonatomic,strong) NSNumber *pushedConnected;
+@property (nonatomic,strong) NSNumber *pushedCentralState;
+@property (nonatomic,assign) unsigned long long pushedVersion;
+// isConnected as of the last status change, for answering off the main thread; nil until initialised
+@property (atomic,strong) NSNumber *connectedState;
+@property (nonatomic,strong) AirTurnCommandTimings *commandTimings;
+// serial, so subscription commands run off main in the order they were sent
+@property (nonatomic,strong) dispatch_queue_t commandQueue;
+// main queue only: hand batches to the page with callAsyncJavaScript where the WebView supports it
+@property (nonatomic,assign) BOOL deliverDirectly;
+// main queue only: the settings UI, built once and presented again on every setting call
+@property (nonatomic,strong) UINavigationController *settingsController;
+@property (nonatomic,strong) id settingsPrewarmObserver;
+// processing queue only: stamp batches so airturn.js can report bridge and dispatch times
+@property (nonatomic,assign) BOOL latencyTracking;
+@property (nonatomic,strong,readwrite) dispatch_queue_t processingQueue;
+@property (nonatomic,strong,readwrite) NSOperationQueue *notificationQueue;
+// main queue only: the mode setProcessingMode asked for, applied at the next page load
+@property (nonatomic,assign) BOOL requestedProcessOnMainQueue;
 
 @end
 
@@ -37,9 +104,9 @@ static inline void throwWithName( NSError *error, NSString* name )
 - (void)dealloc
 {
 
-    for ( id observer in self.observerMap) {
+    for ( id observer in [self.observerMap allValues]) {
 
-        [[NSNotificationCenter defaultCenter] removeObserver:observer];
+        [self.notificationCenter removeObserver:observer];
 
     }
 
@@ -54,19 +121,207 @@ static inline void throwWithName( NSError *error, NSString* name )
  */
 - (void)pluginInitialize
 {
+    self.commandQueue = dispatch_queue_create("com.airturn.cordova.commands", DISPATCH_QUEUE_SERIAL);
+    self.commandTimings = [[AirTurnCommandTimings alloc] init];
+
+    // the plugin loads with the app, so reconnecting starts alongside the page load rather than after initAirTurn
+    [[AirTurnReconnector sharedReconnector] start];
+
+    self.initCallbackIds = [NSMutableArray array];
+    self.startupProfile = [[AirTurnStartupProfile alloc] init];
+    self.responderWatchdog = [[AirTurnResponderWatchdog alloc] init];
+    self.subscriptions = [[NSCountedSet alloc] init];
+    self.statusObservers = [NSMutableArray array];
+    [self observeStatus];
+    self.latencyStats = [[AirTurnLatencyStats alloc] init];
+    self.snapshotStore = [[AirTurnSnapshotStore alloc] init];
+
+    BOOL onMainQueue = [[self.commandDelegate.settings objectForKey:[ProcessEventsOnMainQueuePreference lowercaseString]] boolValue];
+    self.requestedProcessOnMainQueue = onMainQueue;
+    [self startProcessingOnMainQueue:onMainQueue];
+    self.sessionRecorder = [[AirTurnSessionRecorder alloc] initWithNotificationCenter:self.notificationCenter notificationQueue:self.notificationQueue];
+
+    // coalescing window in milliseconds, e.g. <preference name="AirTurnEventCoalescingInterval" value="16" />
+    id interval = [self.commandDelegate.settings objectForKey:[EventCoalescingIntervalPreference lowercaseString]];
+    if (interval) {
+        self.eventQueue.coalescingInterval = [interval doubleValue] / 1000.0;
+    }
+
+    // <preference name="AirTurnEventDelivery" value="direct" /> calls airturn.js directly instead of through the bridge
+    self.deliverDirectly = [[self.commandDelegate.settings objectForKey:[EventDeliveryPreference lowercaseString]] isEqual:@"direct"];
+
+    // unacknowledged batches before delivery is held back, e.g. <preference name="AirTurnEventHighWaterMark" value="4" />
+    id highWaterMark = [self.commandDelegate.settings objectForKey:[EventHighWaterMarkPreference lowercaseString]];
+    if (highWaterMark) {
+        self.eventQueue.highWaterMark = [highWaterMark unsignedIntegerValue];
+    }
+
+    // key repeats are folded per window in milliseconds, e.g. <preference name="AirTurnRepeatCoalescingInterval" value="16" />
+    id repeatInterval = [self.commandDelegate.settings objectForKey:[RepeatCoalescingIntervalPreference lowercaseString]];
+    if (repeatInterval) {
+        // the coalescer is only touched on the processing queue
+        NSTimeInterval window = [repeatInterval doubleValue] / 1000.0;
+        dispatch_async(self.processingQueue, ^{
+            self.repeatCoalescer.window = window;
+        });
+    }
+}
+
+/*
+ Build the processing queue, with its target fixed when it is created, and
+ what runs on it: the notification queue, event queue, repeat coalescer,
+ analog streamer and gesture engine. Main queue only.
+ */
+- (void)startProcessingOnMainQueue:(BOOL)onMainQueue
+{
+    // the queue is serial either way, only the thread its blocks run on differs
+    dispatch_queue_t target = onMainQueue ? dispatch_get_main_queue() : dispatch_get_global_queue(QOS_CLASS_USER_INTERACTIVE, 0);
+    dispatch_queue_t processingQueue = dispatch_queue_create_with_target("com.airturn.cordova.events", DISPATCH_QUEUE_SERIAL, target);
+
+    // observer blocks run as operations on the processing queue, one at a time
+    NSOperationQueue *notificationQueue = [[NSOperationQueue alloc] init];
+    notificationQueue.name = @"com.airturn.cordova.notifications";
+    notificationQueue.maxConcurrentOperationCount = 1;
+    notificationQueue.underlyingQueue = processingQueue;
+
+    AirTurnEventQueue *eventQueue = [[AirTurnEventQueue alloc] initWithQueue:processingQueue delegate:self];
+    eventQueue.latencyStats = self.latencyStats;
+
+    // observeEventName: reads the notification queue from the command queue
+    @synchronized(self) {
+        _processOnMainQueue = onMainQueue;
+        self.processingQueue = processingQueue;
+        self.notificationQueue = notificationQueue;
+        self.eventQueue = eventQueue;
+        self.repeatCoalescer = [[AirTurnRepeatCoalescer alloc] initWithEventQueue:eventQueue];
+        self.analogStreamer = [[AirTurnAnalogStreamer alloc] initWithEventQueue:eventQueue notificationCenter:self.notificationCenter notificationQueue:notificationQueue];
+        self.gestureEngine = [[AirTurnGestureEngine alloc] initWithEventQueue:eventQueue notificationCenter:self.notificationCenter notificationQueue:notificationQueue];
+    }
+}
+
+/*
+ Swap in a new processing queue for the requested mode rather than retarget
+ the live one. Called at a page load, where the page's event stream,
+ acknowledgements, subscriptions, analog stream and gestures end anyway, so
+ only the coalescing settings carry over. Main queue only.
+ */
+- (void)restartProcessing
+{
+    dispatch_queue_t oldProcessingQueue = self.processingQueue;
+    AirTurnEventQueue *oldEventQueue = self.eventQueue;
+    AirTurnRepeatCoalescer *oldRepeatCoalescer = self.repeatCoalescer;
+
+    [self startProcessingOnMainQueue:self.requestedProcessOnMainQueue];
+
+    // a recording spans page loads, so it keeps the queue it started on
+    if (!self.sessionRecorder.path) {
+        self.sessionRecorder = [[AirTurnSessionRecorder alloc] initWithNotificationCenter:self.notificationCenter notificationQueue:self.notificationQueue];
+    }
+
+    // the new page's work waits until the old queue has finished the last page's
+    dispatch_queue_t processingQueue = self.processingQueue;
+    AirTurnEventQueue *eventQueue = self.eventQueue;
+    AirTurnRepeatCoalescer *repeatCoalescer = self.repeatCoalescer;
+    dispatch_suspend(processingQueue);
+
+    dispatch_async(oldProcessingQueue, ^{
+        self.callbackId = nil;
+        [oldRepeatCoalescer reset];
+        [oldEventQueue reset];
+
+        // blocks queued before the swap reach the new event queue through self
+        [repeatCoalescer reset];
+        [eventQueue reset];
+        eventQueue.coalescingInterval = oldEventQueue.coalescingInterval;
+        eventQueue.highWaterMark = oldEventQueue.highWaterMark;
+        repeatCoalescer.window = oldRepeatCoalescer.window;
+
+        dispatch_resume(processingQueue);
+    });
+}
+
+- (void)flushEvents
+{
+    [self.repeatCoalescer flush];
+    [self.eventQueue flush];
+}
+
+- (void)onReset
+{
+    // the page is reloading, its stream callback and any queued events are gone
+    [self.analogStreamer stop];
+    [self.gestureEngine stop];
+    [self.responderWatchdog stop];
+    self.responderWatchdog.textEditing = NO;
+
+    // the reloaded page subscribes again to what it listens to
+    @synchronized(self) {
+        for (NSString *eventName in [self.subscriptions allObjects]) {
+            [self stopObservingEventName:eventName];
+        }
+        [self.subscriptions removeAllObjects];
+    }
+    [self forgetPushedStatus];
+
+    if (self.requestedProcessOnMainQueue != self.processOnMainQueue) {
+        [self restartProcessing];
+        return;
+    }
+
+    dispatch_async(self.processingQueue, ^{
+        self.callbackId = nil;
+        [self.repeatCoalescer reset];
+        [self.eventQueue reset];
+    });
 }
 
 - (void)onAppTerminate
 {
-    for ( id observer in self.observerMap) {
+    @synchronized(self) {
+        for ( id observer in [self.observerMap allValues]) {
+
+            [self.notificationCenter removeObserver:observer];
+
+        }
 
-        [[NSNotificationCenter defaultCenter] removeObserver:observer];
+        [_observerMap removeAllObjects];
 
+        _observerMap = nil;
+        [self.subscriptions removeAllObjects];
     }
 
-    [_observerMap removeAllObjects];
+    for (id observer in self.statusObservers) {
+        [self.notificationCenter removeObserver:observer];
+    }
+    [self.statusObservers removeAllObjects];
 
-    _observerMap = nil;
+    if (self.centralStateObserver) {
+        [self.notificationCenter removeObserver:self.centralStateObserver];
+        self.centralStateObserver = nil;
+    }
+
+    if (self.settingsPrewarmObserver) {
+        [[NSNotificationCenter defaultCenter] removeObserver:self.settingsPrewarmObserver];
+        self.settingsPrewarmObserver = nil;
+    }
+
+    [self.analogStreamer stop];
+    [self.gestureEngine stop];
+    [self.responderWatchdog stop];
+
+    dispatch_async(self.processingQueue, ^{
+        [self.repeatCoalescer reset];
+        [self.eventQueue reset];
+    });
+}
+
+- (NSNotificationCenter *)notificationCenter
+{
+    if (!_notificationCenter) {
+        _notificationCenter = [NSNotificationCenter defaultCenter];
+    }
+
+    return _notificationCenter;
 }
 
 -(NSMutableDictionary *)observerMap
@@ -78,130 +333,448 @@ static inline void throwWithName( NSError *error, NSString* name )
     return _observerMap;
 }
 
-- (void)fireEvent:(NSString *)eventName data:(NSDictionary*)data
+- (void)fireEvent:(AirTurnEventEncoder *)encoder data:(NSDictionary*)data receivedAt:(uint64_t)receivedAt
 {
     if (!self.commandDelegate ) {
         return;
     }
 
-    if (eventName == nil || [eventName length] == 0) {
+    if (encoder.kind == AirTurnEventKindPedalPress && [self.repeatCoalescer foldPress:data receivedAt:receivedAt]) {
+        return;
+    }
+
+    if (encoder.kind == AirTurnEventKindConnectionState)
+    {
+        AirTurnPeripheral *p = data[AirTurnPeripheralKey];
+        switch([data[AirTurnConnectionStateKey] intValue]) {
+            case AirTurnConnectionStateReady:
+                if (p) {
+                    [[AirTurnPeripheralInfoCache sharedCache] peripheralDidBecomeReady:p];
+                }
+                break;
+            default: break;
+        }
+    }
+
+    [self.eventQueue enqueueEvent:encoder userInfo:data];
 
-        @throw [NSException exceptionWithName:NSInvalidArgumentException
-                                       reason:@"eventName is null or empty"
-                                     userInfo:nil];
+}
 
+- (void)eventQueue:(AirTurnEventQueue *)queue deliverBatch:(NSString *)batch count:(NSUInteger)count
+{
+    if (!self.commandDelegate ) {
+        return;
     }
 
-    NSString *jsonDataString = @"{}";
+    NSString *callbackId = self.callbackId;
+    BOOL tracking = self.latencyTracking;
+    uint64_t flushedAt = AirTurnLatencyNow();
 
-    if( data  ) {
+    // everything up to here ran on the processing queue, only the hand-off needs main
+    void (^handOff)(void) = ^{
+        [self.latencyStats recordStage:AirTurnLatencyStageHandOff since:flushedAt];
 
-        NSError *error;
-        NSDictionary *tmpData = data;
-        if([eventName isEqualToString:@"AirTurnConnectionStateNotification"])
-        {
-            //AirTurnPeripheral *p = [data objectForKey:@"AirTurnPeripheralKey"];
-
-            AirTurnPeripheral *p = data[AirTurnPeripheralKey];
-            switch([data[AirTurnConnectionStateKey] intValue]) {
-                case AirTurnConnectionStateReady:
-
-                    [[NSUserDefaults standardUserDefaults] setObject:p.name forKey:@"PeripheralName"];
-                    [[NSUserDefaults standardUserDefaults] setObject:p.identifier forKey:@"DeviceUniqueIdentifier"];
-                    [[NSUserDefaults standardUserDefaults] setObject:p.firmwareVersion forKey:@"FirmwareVersion"];
-                    [[NSUserDefaults standardUserDefaults] setObject:p.hardwareVersion forKey:@"HardwareVersion"];
-                    [[NSUserDefaults standardUserDefaults] synchronize];
-                    break;
-                default: break;
+        // wall clock milliseconds, the only clock airturn.js can compare against
+        double sentAt = tracking ? (CFAbsoluteTimeGetCurrent() + kCFAbsoluteTimeIntervalSince1970) * 1000.0 : 0;
+
+        void (^bridge)(void) = ^{
+            [self deliverBatchThroughBridge:batch callbackId:callbackId tracking:tracking sentAt:sentAt];
+        };
+
+        // the batch stays the JSON string the event queue built, which the page parses once, rather
+        // than being parsed here into Foundation objects for WebKit to convert again
+        if (self.deliverDirectly && [self callPageFunction:DirectDeliveryFunctionBody arguments:@{ @"batch": batch, @"sentAt": @(sentAt) } completionHandler:^(NSError *error) {
+            if (error) {
+                // window.airturn is missing or the batch didn't parse, nothing was dispatched
+                NSLog(@"AirTurn: direct delivery failed, using the bridge: %@", error.localizedDescription);
+                bridge();
             }
-            tmpData = @{
-                        @"AirTurnConnectionStateKey":[data objectForKey:@"AirTurnConnectionStateKey"]
-                        };
-        }
-        else if([eventName isEqualToString:@"AirTurnPedalPressNotification"])
-        {
-            tmpData = @{
-                        @"AirTurnPortNumberKey":[data objectForKey:@"AirTurnPortNumberKey"]
-                        };
+        }]) {
+            return;
         }
 
-        NSData *jsonData = [NSJSONSerialization dataWithJSONObject:tmpData
-                                                           options:(NSJSONWritingOptions)0
-                                                             error:&error];
+        bridge();
+    };
 
-        if (! jsonData) {
+    if ([NSThread isMainThread]) {
+        handOff();
+    } else {
+        dispatch_async(dispatch_get_main_queue(), handOff);
+    }
+}
 
-            throwWithName(error, @"JSON Serialization exception");
-            return;
+- (void)deliverBatchThroughBridge:(NSString *)batch callbackId:(NSString *)callbackId tracking:(BOOL)tracking sentAt:(double)sentAt
+{
+    if (callbackId) {
+        // a JSON string the JS side parses, rather than source text it has to compile
+        NSString *message = tracking ? [NSString stringWithFormat:@"{\"sentAt\":%.3f,\"events\":%@}", sentAt, batch] : batch;
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsString:message];
+        [pluginResult setKeepCallbackAsBool:YES];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:callbackId];
+        return;
+    }
 
+    NSString *func = tracking ? [NSString stringWithFormat:@"window.airturn.fireEvents(%@, %.3f);", batch, sentAt] : [NSString stringWithFormat:@"window.airturn.fireEvents(%@);", batch];
+
+    [self.commandDelegate evalJs:func];
+}
+
+- (BOOL)canCallPageFunctions
+{
+    if (@available(iOS 14.0, *)) {
+        return [self.webView isKindOfClass:[WKWebView class]];
+    }
+    return NO;
+}
+
+- (BOOL)callPageFunction:(NSString *)body arguments:(NSDictionary *)arguments completionHandler:(void (^)(NSError *error))completionHandler
+{
+    if (@available(iOS 14.0, *)) {
+        if ([self.webView isKindOfClass:[WKWebView class]]) {
+            [(WKWebView *)self.webView callAsyncJavaScript:body arguments:arguments inFrame:nil inContentWorld:[WKContentWorld pageWorld] completionHandler:completionHandler ? ^(id result, NSError *error) {
+                completionHandler(error);
+            } : nil];
+            return YES;
         }
+    }
+    return NO;
+}
+
+/*
+ "direct" hands batches to airturn.js with callAsyncJavaScript, "bridge" (the
+ default) through the event stream callback or evalJs. Answers whether direct
+ delivery is available; where it is not, batches keep going through the bridge.
+ */
+- (void)setEventDelivery:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
 
-        jsonDataString = [[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding];
+    NSString *mode = [command argumentAtIndex:0 withDefault:@"" andClass:[NSString class]];
 
+    if (![mode isEqualToString:@"direct"] && ![mode isEqualToString:@"bridge"]) {
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"mode must be 'direct' or 'bridge'"];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+        return;
     }
 
-    NSString *func = [NSString stringWithFormat:@"window.airturn.fireEvent('%@', %@);", eventName, jsonDataString];
+    self.deliverDirectly = [mode isEqualToString:@"direct"];
 
-    [self.commandDelegate evalJs:func];
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsBool:self.canCallPageFunctions];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+- (void)openEventStream:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    dispatch_async(self.processingQueue, ^{
+        // anything queued before the stream opened still goes out in order
+        [self.eventQueue flush];
 
+        self.callbackId = command.callbackId;
+    });
+
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_NO_RESULT];
+    [pluginResult setKeepCallbackAsBool:YES];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
 }
 
-- (void)getInfo:(CDVInvokedUrlCommand*)command
+- (void)closeEventStream:(CDVInvokedUrlCommand*)command
 {
-    NSString *name =  [[NSUserDefaults standardUserDefaults] stringForKey:@"PeripheralName"];
-    NSString *identifier = [[NSUserDefaults standardUserDefaults] stringForKey:@"DeviceUniqueIdentifier"];
-    NSString *firmwareVersion = [[NSUserDefaults standardUserDefaults] stringForKey:@"FirmwareVersion"];
-    NSString *hardwareVersion =[[NSUserDefaults standardUserDefaults] stringForKey:@"HardwareVersion"];
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
 
-    if(name == nil)
-    {
-        name = @"Unknown";
-    }
-    if(identifier == nil)
-    {
-        identifier = @"Unknown";
-    }
-    if(firmwareVersion == nil)
-    {
-        firmwareVersion = @"Unknown";
+    dispatch_async(self.processingQueue, ^{
+        [self.eventQueue flush];
+
+        NSString *callbackId = self.callbackId;
+        self.callbackId = nil;
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (callbackId) {
+                CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_NO_RESULT];
+                [pluginResult setKeepCallbackAsBool:NO];
+                [self.commandDelegate sendPluginResult:pluginResult callbackId:callbackId];
+            }
+
+            CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+            [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+        });
+    });
+}
+
+- (void)setEventCoalescing:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSNumber *interval = [command argumentAtIndex:0 withDefault:nil andClass:[NSNumber class]];
+
+    if (interval == nil || [interval doubleValue] < 0) {
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"interval must be a number of milliseconds >= 0"];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+        return;
     }
-    if(hardwareVersion == nil)
-    {
-        hardwareVersion = @"Unknown";
+
+    dispatch_async(self.processingQueue, ^{
+        // deliver anything queued under the old window first so ordering is preserved
+        [self.eventQueue flush];
+        self.eventQueue.coalescingInterval = [interval doubleValue] / 1000.0;
+    });
+
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+- (void)setRepeatCoalescing:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSNumber *window = [command argumentAtIndex:0 withDefault:nil andClass:[NSNumber class]];
+
+    if (window == nil || [window doubleValue] < 0) {
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"window must be a number of milliseconds >= 0"];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+        return;
     }
 
-    NSDictionary *dic = @{
-                          @"PeripheralName": name,
-                          @"DeviceUniqueIdentifier": identifier,
-                          @"FirmwareVersion": firmwareVersion,
-                          @"HardwareVersion": hardwareVersion
-                          };
+    dispatch_async(self.processingQueue, ^{
+        self.repeatCoalescer.window = [window doubleValue] / 1000.0;
+    });
+
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+- (void)getInfo:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSString *identifier = [command argumentAtIndex:0 withDefault:nil andClass:[NSString class]];
 
-    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:dic];
+    // the info cache is thread safe
+    [self.commandDelegate runInBackground:^{
+        AirTurnTimeBackgroundCommand(self.commandTimings, command.methodName);
+
+        NSDictionary *dic = [[AirTurnPeripheralInfoCache sharedCache] infoForIdentifier:identifier];
+
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:dic];
+
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+    }];
+}
+
+- (void)getSnapshot:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSNumber *sinceVersion = [command argumentAtIndex:0 withDefault:@0 andClass:[NSNumber class]];
+
+    NSDictionary *snapshot = [self.snapshotStore snapshotSinceVersion:[sinceVersion unsignedLongLongValue]];
+
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:snapshot];
 
     [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
 }
 
-- (void)initAirTurn:(CDVInvokedUrlCommand*)command
+/*
+ Logging is process wide, so it is set up once however many times the plugin
+ is initialized, and a logger the app registered itself is not added twice.
+ */
+static void AirTurnSetUpLogging(void)
 {
-    NSLog(@"pluginInitialize");
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
 #if DEBUG
-    [AirTurnLogging setFrameworkLogLevel:AirTurnLogLevelDebug];
+        [AirTurnLogging setFrameworkLogLevel:AirTurnLogLevelDebug];
 #else
-    [AirTurnLogging setFrameworkLogLevel:AirTurnLogLevelInfo];
+        [AirTurnLogging setFrameworkLogLevel:AirTurnLogLevelInfo];
 #endif
-    [DDLog addLogger:[DDASLLogger sharedInstance]];
-    [DDLog addLogger:[DDTTYLogger sharedInstance]];
+        NSArray *loggers = [DDLog allLoggers];
+        if (![loggers containsObject:[DDASLLogger sharedInstance]]) {
+            [DDLog addLogger:[DDASLLogger sharedInstance]];
+        }
+        if (![loggers containsObject:[DDTTYLogger sharedInstance]]) {
+            [DDLog addLogger:[DDTTYLogger sharedInstance]];
+        }
+    });
+}
 
-    [AirTurnManager sharedManager];
+/*
+ Idempotent: calls while starting are answered together once ready, later
+ calls (a reloaded page) straight away. Answers with the startup profile.
+ */
+- (void)initAirTurn:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
 
-    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    if (self.initState == AirTurnInitStateReady) {
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:[self.startupProfile dictionaryRepresentation]];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+        return;
+    }
+
+    [self.initCallbackIds addObject:command.callbackId];
+    if (self.initState == AirTurnInitStateStarting) {
+        return;
+    }
+
+    NSLog(@"pluginInitialize");
+    self.initState = AirTurnInitStateStarting;
+    [self.startupProfile start];
+    [self observeFirstCentralState];
+
+    [self.commandDelegate runInBackground:^{
+        uint64_t loggingStart = AirTurnLatencyNow();
+        AirTurnSetUpLogging();
+        uint64_t logging = AirTurnLatencyNow() - loggingStart;
+
+        // the manager sets up its keyboard view, so it is created on main, but no longer inside the command
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self.startupProfile recordPhase:AirTurnStartupPhaseLogging nanoseconds:logging];
+
+            uint64_t managerStart = AirTurnLatencyNow();
+            [AirTurnManager sharedManager];
+            [self.startupProfile recordPhase:AirTurnStartupPhaseManager nanoseconds:AirTurnLatencyNow() - managerStart];
+
+            [self didFinishInit];
+        });
+    }];
+}
+
+- (void)didFinishInit
+{
+    uint64_t elapsed = AirTurnLatencyNow() - self.startupProfile.startedAt;
+    [self.startupProfile recordPhase:AirTurnStartupPhaseReady nanoseconds:elapsed];
+    self.initState = AirTurnInitStateReady;
+
+    NSDictionary *profile = [self.startupProfile dictionaryRepresentation];
+    for (NSString *callbackId in self.initCallbackIds) {
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:profile];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:callbackId];
+    }
+    [self.initCallbackIds removeAllObjects];
+    [self pushStatus];
+    [self prewarmSettings];
+
+    dispatch_async(self.processingQueue, ^{
+        [self.eventQueue enqueueEvent:[AirTurnEventEncoder encoderForEventName:@"AirTurnReady"] payload:^(AirTurnEventBuffer *buffer) {
+            AirTurnEventBufferAppendLiteral(buffer, "{\"elapsed\":");
+            AirTurnEventBufferAppendInteger(buffer, (long long)(elapsed / NSEC_PER_MSEC));
+            AirTurnEventBufferAppendLiteral(buffer, "}");
+        }];
+    });
+}
+
+- (void)observeFirstCentralState
+{
+    if (self.centralStateObserver) {
+        return;
+    }
+
+    // the reconnector enables the central in pluginInitialize, so its first state has usually come already
+    if ([AirTurnCentral initialized] && [AirTurnCentral sharedCentral].state != AirTurnCentralStateUnknown) {
+        [self.startupProfile recordPhase:AirTurnStartupPhaseFirstCentralState nanoseconds:0];
+        return;
+    }
+
+    __weak AirTurn *weakSelf = self;
+    self.centralStateObserver = [self.notificationCenter addObserverForName:AirTurnCentralStateChangedNotification object:nil queue:[NSOperationQueue mainQueue] usingBlock:^(NSNotification *note) {
+        AirTurn *strongSelf = weakSelf;
+        if (!strongSelf || !strongSelf.centralStateObserver) {
+            return;
+        }
+        [strongSelf.startupProfile recordPhase:AirTurnStartupPhaseFirstCentralState nanoseconds:AirTurnLatencyNow() - strongSelf.startupProfile.startedAt];
+        [strongSelf.notificationCenter removeObserver:strongSelf.centralStateObserver];
+        strongSelf.centralStateObserver = nil;
+    }];
+}
 
+/*
+ Keep airturn.js's state store current while it listens for AirTurnStatus:
+ isConnected, the central state, and the snapshot entries that changed since
+ the last push, pushed whenever one of them may have changed.
+ */
+- (void)observeStatus
+{
+    __weak AirTurn *weakSelf = self;
+    void (^changed)(NSNotification *) = ^(NSNotification *note) {
+        [weakSelf pushStatus];
+    };
+
+    NSOperationQueue *mainQueue = [NSOperationQueue mainQueue];
+    for (NSString *name in @[AirTurnCentralStateChangedNotification,
+                             AirTurnConnectionStateChangedNotification,
+                             AirTurnDidUpdateBatteryLevelNotification,
+                             AirTurnDidUpdateChargingStateNotification,
+                             AirTurnDidUpdateCurrentModeNotification,
+                             AirTurnDidUpdateNameNotification,
+                             AirTurnKeyboardStateMonitorExternalKeyboardStateChangedNotification]) {
+        [self.statusObservers addObject:[self.notificationCenter addObserverForName:name object:nil queue:mainQueue usingBlock:changed]];
+    }
+}
+
+- (void)forgetPushedStatus
+{
+    self.pushedConnected = nil;
+    self.pushedCentralState = nil;
+    self.pushedVersion = 0;
+}
+
+- (void)pushStatus
+{
+    // don't bring the manager up early just to read it
+    if (self.initState != AirTurnInitStateReady) {
+        return;
+    }
+
+    BOOL connected = [AirTurnManager sharedManager].isConnected;
+    self.connectedState = @(connected);
+
+    @synchronized(self) {
+        if ([self.subscriptions countForObject:StatusEventName] == 0) {
+            return;
+        }
+    }
+
+    NSDictionary *snapshot = [self.snapshotStore snapshotSinceVersion:self.pushedVersion];
+    NSNumber *centralState = snapshot[@"centralState"];
+    unsigned long long version = [snapshot[@"version"] unsignedLongLongValue];
+
+    if ([self.pushedConnected isEqualToNumber:@(connected)] && [self.pushedCentralState isEqualToNumber:centralState] && version == self.pushedVersion) {
+        return;
+    }
+    self.pushedConnected = @(connected);
+    self.pushedCentralState = centralState;
+    self.pushedVersion = version;
+
+    NSMutableDictionary *status = [snapshot mutableCopy];
+    status[@"connected"] = @(connected);
+    NSData *json = [NSJSONSerialization dataWithJSONObject:status options:(NSJSONWritingOptions)0 error:nil];
+    if (!json) {
+        return;
+    }
+
+    dispatch_async(self.processingQueue, ^{
+        [self.eventQueue enqueueEvent:[AirTurnEventEncoder encoderForEventName:StatusEventName] payload:^(AirTurnEventBuffer *buffer) {
+            AirTurnEventBufferAppend(buffer, json.bytes, json.length);
+        }];
+    });
+}
+
+- (void)getStartupProfile:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSMutableDictionary *profile = [[self.startupProfile dictionaryRepresentation] mutableCopy];
+    profile[@"reconnect"] = [[AirTurnReconnector sharedReconnector] dictionaryRepresentation];
+
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:profile];
     [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
 }
 
 - (void)makeActive:(CDVInvokedUrlCommand*)command
 {
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
     AirTurnViewManager* vManager = [[AirTurnManager sharedManager] viewManager];
     BOOL first = [vManager isFirstResponder];
     if (!first)
@@ -215,78 +788,358 @@ static inline void throwWithName( NSError *error, NSString* name )
 }
 
 
+/*
+ Answered in the background from the state kept by the status observers. The
+ manager is main-thread only, so before initAirTurn has finished it is read on
+ main as before.
+ */
 - (void)isConnected:(CDVInvokedUrlCommand*)command
 {
-    BOOL connected = FALSE;
-    connected = [AirTurnManager sharedManager].isConnected;
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
 
-    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsBool:connected];
+    [self.commandDelegate runInBackground:^{
+        NSNumber *connected = self.connectedState;
+        if (!connected) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                AirTurnTimeBackgroundCommand(self.commandTimings, command.methodName);
 
-    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+                CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsBool:[AirTurnManager sharedManager].isConnected];
+                [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+            });
+            return;
+        }
+
+        AirTurnTimeBackgroundCommand(self.commandTimings, command.methodName);
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsBool:[connected boolValue]];
+
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+    }];
 }
 
 
-- (void)addEventListener:(CDVInvokedUrlCommand*)command
+- (void)observeEventName:(NSString *)eventName
+{
+    @synchronized(self) {
+        id observer = self.observerMap[eventName];
+
+        if (!observer) {
+            observer = [self addObserverForEventName:eventName center:self.notificationCenter];
+            [self.observerMap setObject:observer forKey:eventName];
+        }
+    }
+}
+
+// an observer that sends the event to the page
+- (id)addObserverForEventName:(NSString *)eventName center:(NSNotificationCenter *)center
+{
+    __typeof(self) __weak weakSelf = self;
+    AirTurnEventEncoder *encoder = [AirTurnEventEncoder encoderForEventName:eventName];
+
+    return [center addObserverForName:eventName
+                               object:nil
+                                queue:self.notificationQueue
+                           usingBlock:^(NSNotification *note) {
+
+        __typeof(self) __strong strongSelf = weakSelf;
+        uint64_t receivedAt = AirTurnLatencyNow();
+
+        [strongSelf fireEvent:encoder data:note.userInfo receivedAt:receivedAt];
+
+        [strongSelf.latencyStats recordStage:AirTurnLatencyStageEncode since:receivedAt];
+    }];
+}
+
+- (void)stopObservingEventName:(NSString *)eventName
 {
-    CDVPluginResult* pluginResult;
+    @synchronized(self) {
+        id observer = self.observerMap[eventName];
 
-    __block NSString* eventName = command.arguments[0];
+        if (observer) {
+            [self.notificationCenter removeObserver:observer];
+            [self.observerMap removeObjectForKey:eventName];
+        }
+    }
+}
+
+- (void)setProcessingMode:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSString *mode = [command argumentAtIndex:0 withDefault:@"" andClass:[NSString class]];
 
-    if (eventName == nil || [eventName length] == 0) {
-        pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"eventName is null or empty"];
+    if (![mode isEqualToString:@"main"] && ![mode isEqualToString:@"background"]) {
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"mode must be 'main' or 'background'"];
         [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
         return;
     }
 
-    id observer = self.observerMap[eventName];
+    // a new processing queue is swapped in when the page next loads, see restartProcessing
+    self.requestedProcessOnMainQueue = [mode isEqualToString:@"main"];
 
-    if (!observer) {
-        __typeof(self) __weak weakSelf = self;
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
 
-        observer = [[NSNotificationCenter defaultCenter] addObserverForName:eventName
-                                                                     object:nil
-                                                                      queue:[NSOperationQueue mainQueue]
-                                                                 usingBlock:^(NSNotification *note) {
+- (void)startAnalogStream:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
 
-             __typeof(self) __strong strongSelf = weakSelf;
+    NSDictionary *options = [command argumentAtIndex:0 withDefault:nil andClass:[NSDictionary class]];
 
-             [strongSelf fireEvent:eventName data:note.userInfo];
-             }];
-        [self.observerMap setObject:observer forKey:eventName];
-    }
+    [self.analogStreamer startWithOptions:options];
+
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+- (void)stopAnalogStream:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    [self.analogStreamer stop];
+
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+- (void)startGestures:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSDictionary *options = [command argumentAtIndex:0 withDefault:nil andClass:[NSDictionary class]];
+
+    [self.gestureEngine startWithOptions:options];
+
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+- (void)stopGestures:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    [self.gestureEngine stop];
+
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+- (void)startResponderWatchdog:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSDictionary *options = [command argumentAtIndex:0 withDefault:nil andClass:[NSDictionary class]];
 
-    pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    [self.responderWatchdog startWithOptions:options];
 
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+- (void)stopResponderWatchdog:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    [self.responderWatchdog stop];
+
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
     [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+/*
+ Sent by airturn.js without callbacks when an editable element gains or loses
+ focus, so no result goes back across the bridge.
+ */
+- (void)setTextEditing:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSNumber *editing = [command argumentAtIndex:0 withDefault:@NO andClass:[NSNumber class]];
+
+    self.responderWatchdog.textEditing = [editing boolValue];
+}
 
+- (void)getResponderWatchdogStats:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:[self.responderWatchdog statistics]];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+- (void)startRecording:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSString *name = [command argumentAtIndex:0 withDefault:nil andClass:[NSString class]];
+
+    NSError *error;
+    NSString *path = [self.sessionRecorder startWithName:name error:&error];
+
+    CDVPluginResult* pluginResult = path ? [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsString:path] : [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:error.localizedDescription];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+- (void)stopRecording:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    [self.sessionRecorder stopWithCompletion:^(NSDictionary *result) {
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:result];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+    }];
+}
+
+- (void)replaySession:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSString *path = [command argumentAtIndex:0 withDefault:@"" andClass:[NSString class]];
+    NSNumber *speed = [command argumentAtIndex:1 withDefault:@1 andClass:[NSNumber class]];
+
+    [self.commandDelegate runInBackground:^{
+        NSError *error;
+        AirTurnSessionReplayer *replayer = [[AirTurnSessionReplayer alloc] initWithContentsOfFile:path error:&error];
+        CDVPluginResult* pluginResult;
+
+        if (replayer) {
+            // replayed notifications have no AirTurnPeripheral and are posted from this thread, so they
+            // go to a private center that only feeds the page, never to the app's own observers
+            NSNotificationCenter *center = [[NSNotificationCenter alloc] init];
+            NSMutableArray *observers = [NSMutableArray array];
+            @synchronized(self) {
+                for (NSString *eventName in self.subscriptions) {
+                    [observers addObject:[self addObserverForEventName:eventName center:center]];
+                }
+            }
+
+            [replayer replayToCenter:center speed:[speed doubleValue]];
+
+            for (id observer in observers) {
+                [center removeObserver:observer];
+            }
+            pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:@{ @"notifications": @(replayer.notifications.count), @"duration": @(replayer.duration) }];
+        } else {
+            pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:error.localizedDescription];
+        }
+
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+    }];
+}
+
+/*
+ airturn.js subscribes when an event name gets its first listener and
+ unsubscribes when it loses its last, so the observer, and the encoding behind
+ it, only exist while something listens. Answers with the event ID the event
+ is sent as, or with the name for a name that has none.
+
+ Subscription commands run on the serial command queue rather than with
+ runInBackground, so a remove never overtakes the add before it.
+ */
+- (void)addEventListener:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    dispatch_async(self.commandQueue, ^{
+        AirTurnTimeBackgroundCommand(self.commandTimings, command.methodName);
+
+        CDVPluginResult* pluginResult;
+
+        NSString* eventName = [command argumentAtIndex:0 withDefault:nil andClass:[NSString class]];
+
+        if (eventName == nil || [eventName length] == 0) {
+            pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"eventName is null or empty"];
+            [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+            return;
+        }
+
+        @synchronized(self) {
+            [self.subscriptions addObject:eventName];
+            [self observeEventName:eventName];
+        }
+
+        NSUInteger eventId = [AirTurnEventEncoder encoderForEventName:eventName].eventId;
+        if (eventId == NSNotFound) {
+            pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsString:eventName];
+        } else {
+            pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsInt:(int)eventId];
+        }
+
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+
+        if ([eventName isEqualToString:StatusEventName]) {
+            // after the ID has gone out, so airturn.js can route it
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [self forgetPushedStatus];
+                [self pushStatus];
+            });
+        }
+    });
 }
 
 - (void)removeEventListener:(CDVInvokedUrlCommand*)command
 {
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    dispatch_async(self.commandQueue, ^{
+        AirTurnTimeBackgroundCommand(self.commandTimings, command.methodName);
 
-    CDVPluginResult* pluginResult;
+        CDVPluginResult* pluginResult;
 
-    __block NSString* eventName = command.arguments[0];
+        NSString* eventName = [command argumentAtIndex:0 withDefault:nil andClass:[NSString class]];
+
+        if (eventName == nil || [eventName length] == 0) {
+            pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"eventName is null or empty"];
+            [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+            return;
+        }
+
+        @synchronized(self) {
+            if ([self.subscriptions countForObject:eventName] > 0) {
+                [self.subscriptions removeObject:eventName];
+                if ([self.subscriptions countForObject:eventName] == 0) {
+                    [self stopObservingEventName:eventName];
+                }
+            }
+        }
+
+        pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
 
-    if (eventName == nil || [eventName length] == 0) {
-        pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"eventName is null or empty"];
         [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
-        return;
-    }
+    });
+}
+
+/*
+ Subscriber count per observed event name
+ */
+- (void)listSubscriptions:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
 
-    id observer = self.observerMap[ eventName ];
+    dispatch_async(self.commandQueue, ^{
+        AirTurnTimeBackgroundCommand(self.commandTimings, command.methodName);
 
-    if (observer) {
+        NSMutableDictionary *subscriptions = [NSMutableDictionary dictionary];
+        @synchronized(self) {
+            for (NSString *eventName in self.subscriptions) {
+                subscriptions[eventName] = @([self.subscriptions countForObject:eventName]);
+            }
+        }
 
-        [[NSNotificationCenter defaultCenter] removeObserver:observer
-                                                        name:eventName
-                                                      object:self];
-    }
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:subscriptions];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+    });
+}
 
-    pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+/*
+ The fixed event ID table, by name. Names outside it are sent by name.
+ */
+- (void)getEventIds:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
 
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:[AirTurnEventEncoder eventIds]];
     [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
-
 }
 
 # pragma mark - Popover Presentation Controller Delegate
@@ -326,18 +1179,143 @@ static inline void throwWithName( NSError *error, NSString* name )
     // called when the Popover changes position
 }
 
-- (void)setting:(CDVInvokedUrlCommand*)command
+/*
+ Building the settings UI (the storyboard, the connection controller with its
+ cells and web view) takes long enough to hitch, so it is built once and
+ reused. The controller keeps observing the AirTurns while off screen, so it is
+ current when shown again. With <preference name="AirTurnPrewarmSettings"
+ value="true" /> it is built ahead of use, when the main run loop is next idle
+ after initAirTurn.
+ */
+- (UINavigationController *)settingsNavigationController
+{
+    if (!self.settingsController) {
+        self.settingsController = [self buildSettingsNavigationController];
+    }
+
+    return self.settingsController;
+}
+
+- (UINavigationController *)buildSettingsNavigationController
 {
     UIStoryboard *mainStoryBoard = [UIStoryboard storyboardWithName:@"Main" bundle:nil];
     UINavigationController *navSetting = [mainStoryBoard instantiateViewControllerWithIdentifier:@"SettingNav"];
     navSetting.modalPresentationStyle = UIModalPresentationPopover;
-	//navSetting.modalPresentationStyle = UIModalPresentationFullScreen;
+    //navSetting.modalPresentationStyle = UIModalPresentationFullScreen;
 
     // add a "Done" button to the parent navigation controller
     UIBarButtonItem *bbi = [[UIBarButtonItem alloc] initWithTitle:NSLocalizedString(@"Done", @"AirTurn UI dismiss button in nav controller") style:UIBarButtonItemStyleDone target:self action:@selector(dismiss)];
     UINavigationController *nc = (UINavigationController *)navSetting; //.presentedViewController;
     nc.topViewController.navigationItem.leftBarButtonItem = bbi;
 
+    return navSetting;
+}
+
+/*
+ What setting up the connection controller can change: it applies the saved
+ mode, which enables or disables the central, the view manager and keyboard
+ management, and writes user defaults.
+ */
+static NSDictionary *SettingsSideEffectState(void)
+{
+    NSString *domain = [[NSBundle mainBundle] bundleIdentifier];
+    return @{
+             @"centralEnabled": @([AirTurnCentral initialized] && [AirTurnCentral sharedCentral].enabled),
+             @"viewManagerEnabled": @([AirTurnViewManager initialized] && [AirTurnViewManager sharedViewManager].enabled),
+             @"keyboardManagementEnabled": @([AirTurnKeyboardManager sharedManager].automaticKeyboardManagementEnabled),
+             @"defaults": [[NSUserDefaults standardUserDefaults] persistentDomainForName:domain] ?: @{}
+             };
+}
+
+static void RestoreSettingsSideEffectState(NSDictionary *state)
+{
+    [[NSUserDefaults standardUserDefaults] setPersistentDomain:state[@"defaults"] forName:[[NSBundle mainBundle] bundleIdentifier]];
+    if ([AirTurnCentral initialized]) {
+        [AirTurnCentral sharedCentral].enabled = [state[@"centralEnabled"] boolValue];
+    }
+    if ([AirTurnViewManager initialized]) {
+        [AirTurnViewManager sharedViewManager].enabled = [state[@"viewManagerEnabled"] boolValue];
+    }
+    [AirTurnKeyboardManager sharedManager].automaticKeyboardManagementEnabled = [state[@"keyboardManagementEnabled"] boolValue];
+}
+
+/*
+ Build the settings UI ahead of use without changing anything only opening it
+ should. If building it changed SettingsSideEffectState, that is put back and
+ nil returned, so the UI is built on first use instead. changed, if given, is
+ set to the keys that changed.
+ */
+- (UINavigationController *)prewarmSettingsNavigationController:(NSArray<NSString *> **)changed
+{
+    NSDictionary *before = SettingsSideEffectState();
+    UINavigationController *controller = [self buildSettingsNavigationController];
+    NSDictionary *after = SettingsSideEffectState();
+
+    NSMutableArray<NSString *> *keys = [NSMutableArray array];
+    for (NSString *key in before) {
+        if (![before[key] isEqual:after[key]]) {
+            [keys addObject:key];
+        }
+    }
+    if (changed) {
+        *changed = keys;
+    }
+    if (keys.count == 0) {
+        return controller;
+    }
+
+    NSLog(@"AirTurn: not prewarming the settings UI, building it changed %@", [keys componentsJoinedByString:@", "]);
+    RestoreSettingsSideEffectState(before);
+    return nil;
+}
+
+- (void)prewarmSettings
+{
+    id prewarm = [self.commandDelegate.settings objectForKey:[PrewarmSettingsPreference lowercaseString]];
+    if (![prewarm boolValue] || self.settingsController || self.settingsPrewarmObserver) {
+        return;
+    }
+
+    __weak AirTurn *weakSelf = self;
+    NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+    self.settingsPrewarmObserver = [center addObserverForName:SettingsPrewarmNotification object:self queue:nil usingBlock:^(NSNotification *note) {
+        AirTurn *strongSelf = weakSelf;
+        if (!strongSelf.settingsPrewarmObserver) {
+            return;
+        }
+        [center removeObserver:strongSelf.settingsPrewarmObserver];
+        strongSelf.settingsPrewarmObserver = nil;
+
+        if (!strongSelf.settingsController) {
+            strongSelf.settingsController = [strongSelf prewarmSettingsNavigationController:NULL];
+        }
+    }];
+
+    // posted by the main run loop once it has nothing else to do, so it never delays an event
+    [[NSNotificationQueue defaultQueue] enqueueNotification:[NSNotification notificationWithName:SettingsPrewarmNotification object:self] postingStyle:NSPostWhenIdle];
+}
+
+- (void)onMemoryWarning
+{
+    [super onMemoryWarning];
+
+    // built again on the next setting call
+    if (!self.settingsController.presentingViewController) {
+        self.settingsController = nil;
+    }
+}
+
+- (void)setting:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    UINavigationController *navSetting = [self settingsNavigationController];
+    if (navSetting.presentingViewController) {
+        return;
+    }
+    // a reopened settings UI starts from the list, as a new one did
+    [navSetting popToRootViewControllerAnimated:NO];
+
     [self.viewController presentViewController:navSetting animated:YES completion:nil];
 
     UIPopoverPresentationController *popController = [navSetting popoverPresentationController];
@@ -347,6 +1325,186 @@ static inline void throwWithName( NSError *error, NSString* name )
     popController.delegate = self;
 }
 
+- (void)runBenchmark:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSString *name = [command argumentAtIndex:0 withDefault:@"" andClass:[NSString class]];
+    NSDictionary *options = [command argumentAtIndex:1 withDefault:@{} andClass:[NSDictionary class]];
+
+    // sends probes to the page from the main thread, and answers when they are done
+    if ([name isEqualToString:@"delivery"]) {
+        [AirTurnDeliveryBenchmark runWithPlugin:self callbackId:command.callbackId options:options];
+        return;
+    }
+
+    // builds a throwaway settings UI the way the prewarm does, on main where UIKit needs it
+    if ([name isEqualToString:@"settings"]) {
+        NSDictionary *before = SettingsSideEffectState();
+        uint64_t start = AirTurnLatencyNow();
+        NSArray<NSString *> *changed;
+        UINavigationController *controller = [self prewarmSettingsNavigationController:&changed];
+        uint64_t elapsed = AirTurnLatencyNow() - start;
+        NSDictionary *result = @{
+                                 @"elapsed": @((double)elapsed / NSEC_PER_MSEC),
+                                 @"prewarmed": @(controller != nil),
+                                 @"changed": changed,
+                                 @"unchanged": @([SettingsSideEffectState() isEqual:before])
+                                 };
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:result];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+        return;
+    }
+
+    [self.commandDelegate runInBackground:^{
+        CDVPluginResult* pluginResult;
+
+        if ([name isEqualToString:@"encoder"]) {
+            pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:[AirTurnEncoderBenchmark run]];
+        } else if ([name isEqualToString:@"processing"]) {
+            pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:[AirTurnProcessingBenchmark run]];
+        } else if ([name isEqualToString:@"load"] && [options[@"session"] isKindOfClass:[NSString class]]) {
+            NSError *error;
+            AirTurnSessionReplayer *session = [[AirTurnSessionReplayer alloc] initWithContentsOfFile:options[@"session"] error:&error];
+            if (session) {
+                double speed = options[@"speed"] ? [options[@"speed"] doubleValue] : 1;
+                pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:[AirTurnLoadGenerator runSession:session speed:speed]];
+            } else {
+                pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:error.localizedDescription];
+            }
+        } else if ([name isEqualToString:@"load"]) {
+            NSArray *rates = [options[@"rates"] isKindOfClass:[NSArray class]] ? options[@"rates"] : nil;
+            pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:[AirTurnLoadGenerator runWithRates:rates duration:[options[@"duration"] doubleValue]]];
+        } else {
+            pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:[NSString stringWithFormat:@"Unknown benchmark '%@'", name]];
+        }
+
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+    }];
+}
+
+- (void)getLatencyStats:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    [self.commandDelegate runInBackground:^{
+        AirTurnTimeBackgroundCommand(self.commandTimings, command.methodName);
+
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:[self.latencyStats dictionaryRepresentation]];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+    }];
+}
+
+- (void)resetLatencyStats:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    [self.commandDelegate runInBackground:^{
+        AirTurnTimeBackgroundCommand(self.commandTimings, command.methodName);
+
+        [self.latencyStats reset];
+
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+    }];
+}
+
+- (void)setLatencyTracking:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSNumber *enabled = [command argumentAtIndex:0 withDefault:@NO andClass:[NSNumber class]];
+
+    dispatch_async(self.processingQueue, ^{
+        // batches queued under the old setting go out in the old format
+        [self.eventQueue flush];
+        self.latencyTracking = [enabled boolValue];
+    });
+
+    CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+/*
+ Samples measured by airturn.js, in milliseconds: [bridge[], dispatch[]]
+ */
+- (void)reportLatency:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSArray *bridge = [command argumentAtIndex:0 withDefault:@[] andClass:[NSArray class]];
+    NSArray *dispatchTimes = [command argumentAtIndex:1 withDefault:@[] andClass:[NSArray class]];
+
+    // recording is lock-free
+    [self.commandDelegate runInBackground:^{
+        AirTurnTimeBackgroundCommand(self.commandTimings, command.methodName);
+
+        for (NSNumber *ms in bridge) {
+            // clamp small clock skew between the native and JS wall clocks
+            [self.latencyStats recordStage:AirTurnLatencyStageBridge nanoseconds:(uint64_t)(MAX(0, [ms doubleValue]) * NSEC_PER_MSEC)];
+        }
+        for (NSNumber *ms in dispatchTimes) {
+            [self.latencyStats recordStage:AirTurnLatencyStageDispatch nanoseconds:(uint64_t)(MAX(0, [ms doubleValue]) * NSEC_PER_MSEC)];
+        }
+
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+    }];
+}
+
+/*
+ Time spent in each command, on the main thread and in the background
+ */
+- (void)getCommandStats:(CDVInvokedUrlCommand*)command
+{
+    [self.commandDelegate runInBackground:^{
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:[self.commandTimings dictionaryRepresentation]];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+    }];
+}
+
+- (void)resetCommandStats:(CDVInvokedUrlCommand*)command
+{
+    [self.commandDelegate runInBackground:^{
+        [self.commandTimings reset];
+
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+    }];
+}
+
+/*
+ The number of batches airturn.js has processed since the page loaded. Sent
+ without callbacks, so no result goes back across the bridge.
+ */
+- (void)ackEvents:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    NSNumber *delivered = [command argumentAtIndex:0 withDefault:nil andClass:[NSNumber class]];
+    if (delivered == nil) {
+        return;
+    }
+
+    dispatch_async(self.processingQueue, ^{
+        [self.eventQueue acknowledgeBatches:[delivered unsignedIntegerValue]];
+    });
+}
+
+- (void)getQueueStats:(CDVInvokedUrlCommand*)command
+{
+    AirTurnTimeCommand(self.commandTimings, command.methodName);
+
+    dispatch_async(self.processingQueue, ^{
+        NSDictionary *stats = [self.eventQueue statistics];
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:stats];
+            [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+        });
+    });
+}
+
 - (void)killApp:(CDVInvokedUrlCommand*)command
 {
     kill(getpid(), SIGKILL);
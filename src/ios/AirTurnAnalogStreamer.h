@@ -0,0 +1,41 @@
+//
+//  AirTurnAnalogStreamer.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+#import "AirTurnEventQueue.h"
+
+/**
+ The event name of packed analog frames
+ */
+FOUNDATION_EXTERN NSString * _Nonnull const AirTurnAnalogFrameEvent;
+
+/**
+ Streams analog (expression pedal) port values to Javascript at a bounded rate.
+
+ Every `AirTurnAnalogPortValueChangeNotification` updates the pending value for its peripheral and port. Changes smaller than the dead band relative to the last sent value are dropped. Pending values are sent no more often than each port's rate allows, and all ports due at the same time are packed into one `AirTurnAnalogFrame` event:
+
+     {"values":[["<identifier>",<port>,<value>],...]}
+ */
+@interface AirTurnAnalogStreamer : NSObject
+
+/**
+ @param eventQueue The event queue frames are sent through. The streamer runs on its queue.
+ @param notificationCenter The center notifications are observed on, the plugin's so replayed and synthetic traffic is seen too
+ @param notificationQueue The operation queue notifications are observed on, which must run on the event queue's queue
+ */
+- (nonnull instancetype)initWithEventQueue:(nonnull AirTurnEventQueue *)eventQueue notificationCenter:(nonnull NSNotificationCenter *)notificationCenter notificationQueue:(nonnull NSOperationQueue *)notificationQueue;
+
+@property(nonatomic, readonly) BOOL streaming;
+
+/**
+ Start streaming, or change the options of the running stream
+
+ @param options `rate`: maximum frames per second per port, default 60. `portRates`: per-port overrides, keyed by port number. `deadBand`: smallest change worth sending, default 0. `ports`: port numbers to stream, default all.
+ */
+- (void)startWithOptions:(nullable NSDictionary *)options;
+
+- (void)stop;
+
+@end
@@ -0,0 +1,245 @@
+//
+//  AirTurnAnalogStreamer.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnAnalogStreamer.h"
+#import <AirTurnInterface/AirTurnInterface.h>
+
+NSString * const AirTurnAnalogFrameEvent = @"AirTurnAnalogFrame";
+
+static const double DefaultRate = 60;
+
+typedef struct {
+    AirTurnPeripheralAnalogValue lastSent;
+    AirTurnPeripheralAnalogValue pending;
+    uint64_t lastSentTime;
+    BOOL hasSent;
+    BOOL hasPending;
+} AirTurnAnalogPortState;
+
+@interface AirTurnAnalogPeripheralState : NSObject {
+@public
+    AirTurnAnalogPortState ports[AirTurnPortMaximum + 1];
+}
+
+@property(nonatomic, copy) NSString *identifier;
+
+@end
+
+@implementation AirTurnAnalogPeripheralState
+@end
+
+@interface AirTurnAnalogStreamer() {
+    uint64_t _minimumInterval[AirTurnPortMaximum + 1];
+}
+
+@property(nonatomic, strong) AirTurnEventQueue *eventQueue;
+@property(nonatomic, strong) NSNotificationCenter *notificationCenter;
+@property(nonatomic, strong) NSOperationQueue *notificationQueue;
+@property(nonatomic, strong) AirTurnEventEncoder *encoder;
+@property(nonatomic, strong) id observer;
+
+@property(nonatomic, strong) NSMutableDictionary<NSString *, AirTurnAnalogPeripheralState *> *peripherals;
+@property(nonatomic, assign) NSInteger deadBand;
+@property(nonatomic, assign) uint16_t portMask;
+@property(nonatomic, assign) uint64_t scheduledFrameTime;
+@property(nonatomic, assign) NSUInteger frameGeneration;
+
+@end
+
+@implementation AirTurnAnalogStreamer
+
+- (instancetype)initWithEventQueue:(AirTurnEventQueue *)eventQueue notificationCenter:(NSNotificationCenter *)notificationCenter notificationQueue:(NSOperationQueue *)notificationQueue
+{
+    self = [super init];
+    if (self) {
+        _eventQueue = eventQueue;
+        _notificationCenter = notificationCenter;
+        _notificationQueue = notificationQueue;
+        _encoder = [AirTurnEventEncoder encoderForEventName:AirTurnAnalogFrameEvent];
+        _peripherals = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_observer) {
+        [_notificationCenter removeObserver:_observer];
+    }
+}
+
+- (BOOL)streaming
+{
+    return self.observer != nil;
+}
+
+- (void)startWithOptions:(NSDictionary *)options
+{
+    double rate = [options[@"rate"] doubleValue] > 0 ? [options[@"rate"] doubleValue] : DefaultRate;
+    NSDictionary *portRates = [options[@"portRates"] isKindOfClass:[NSDictionary class]] ? options[@"portRates"] : nil;
+    NSArray *ports = [options[@"ports"] isKindOfClass:[NSArray class]] ? options[@"ports"] : nil;
+    NSInteger deadBand = MAX(0, [options[@"deadBand"] integerValue]);
+
+    uint64_t intervals[AirTurnPortMaximum + 1];
+    uint16_t portMask = 0;
+    for (AirTurnPort port = AirTurnPortMinimum; port <= AirTurnPortMaximum; port++) {
+        NSNumber *key = @(port);
+        double portRate = [portRates[key.stringValue] doubleValue] > 0 ? [portRates[key.stringValue] doubleValue] : rate;
+        intervals[port] = (uint64_t)(NSEC_PER_SEC / portRate);
+        if (!ports || [ports containsObject:key]) {
+            portMask |= (uint16_t)(1 << port);
+        }
+    }
+
+    dispatch_async(self.eventQueue.queue, ^{
+        memcpy(self->_minimumInterval, intervals, sizeof(intervals));
+        self.portMask = portMask;
+        self.deadBand = deadBand;
+    });
+
+    if (!self.observer) {
+        __typeof(self) __weak weakSelf = self;
+        self.observer = [self.notificationCenter addObserverForName:AirTurnAnalogPortValueChangeNotification
+                                                             object:nil
+                                                              queue:self.notificationQueue
+                                                         usingBlock:^(NSNotification *note) {
+            [weakSelf analogValueChanged:note];
+        }];
+    }
+}
+
+- (void)stop
+{
+    if (self.observer) {
+        [self.notificationCenter removeObserver:self.observer];
+        self.observer = nil;
+    }
+
+    dispatch_async(self.eventQueue.queue, ^{
+        [self.peripherals removeAllObjects];
+        self.frameGeneration++;
+        self.scheduledFrameTime = 0;
+    });
+}
+
+#pragma mark - Processing queue
+
+- (void)analogValueChanged:(NSNotification *)note
+{
+    AirTurnPeripheral *p = note.userInfo[AirTurnPeripheralKey];
+    if (!p && [note.object isKindOfClass:[AirTurnPeripheral class]]) {
+        p = note.object;
+    }
+    AirTurnPort port = [note.userInfo[AirTurnPortNumberKey] integerValue];
+    NSString *identifier = p ? p.identifier : note.userInfo[AirTurnEventPeripheralIdentifierKey];
+    if (!identifier || port < AirTurnPortMinimum || port > AirTurnPortMaximum || !(self.portMask & (1 << port))) {
+        return;
+    }
+
+    AirTurnAnalogPeripheralState *state = self.peripherals[identifier];
+    if (!state) {
+        state = [[AirTurnAnalogPeripheralState alloc] init];
+        state.identifier = identifier;
+        self.peripherals[identifier] = state;
+    }
+
+    AirTurnPeripheralAnalogValue value = p ? [p analogPortValue:port] : (AirTurnPeripheralAnalogValue)[note.userInfo[AirTurnEventValueKey] integerValue];
+    AirTurnAnalogPortState *s = &state->ports[port];
+
+    if (s->hasSent && labs((long)value - (long)s->lastSent) < self.deadBand) {
+        // back within the dead band of what JS already has
+        s->hasPending = NO;
+        return;
+    }
+
+    s->pending = value;
+    s->hasPending = YES;
+
+    uint64_t now = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    uint64_t due = s->hasSent ? MAX(now, s->lastSentTime + _minimumInterval[port]) : now;
+    [self scheduleFrameAt:due now:now];
+}
+
+- (void)scheduleFrameAt:(uint64_t)due now:(uint64_t)now
+{
+    if (self.scheduledFrameTime != 0 && self.scheduledFrameTime <= due) {
+        return;
+    }
+
+    // an earlier frame supersedes one already scheduled
+    self.scheduledFrameTime = due;
+    NSUInteger generation = ++self.frameGeneration;
+
+    __typeof(self) __weak weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(due - now)), self.eventQueue.queue, ^{
+        __typeof(self) __strong strongSelf = weakSelf;
+        if (strongSelf.frameGeneration != generation) {
+            return;
+        }
+        strongSelf.scheduledFrameTime = 0;
+        [strongSelf emitFrame];
+    });
+}
+
+- (void)emitFrame
+{
+    uint64_t now = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    uint64_t next = UINT64_MAX;
+    BOOL due = NO;
+
+    for (AirTurnAnalogPeripheralState *state in self.peripherals.objectEnumerator) {
+        for (AirTurnPort port = AirTurnPortMinimum; port <= AirTurnPortMaximum; port++) {
+            AirTurnAnalogPortState *s = &state->ports[port];
+            if (!s->hasPending) {
+                continue;
+            }
+            uint64_t allowed = s->hasSent ? s->lastSentTime + _minimumInterval[port] : 0;
+            if (allowed <= now) {
+                due = YES;
+            } else {
+                next = MIN(next, allowed);
+            }
+        }
+    }
+
+    if (due) {
+        uint64_t *intervals = _minimumInterval;
+        [self.eventQueue enqueueEvent:self.encoder payload:^(AirTurnEventBuffer *buffer) {
+            BOOL first = YES;
+            AirTurnEventBufferAppendLiteral(buffer, "{\"values\":[");
+            for (AirTurnAnalogPeripheralState *state in self.peripherals.objectEnumerator) {
+                for (AirTurnPort port = AirTurnPortMinimum; port <= AirTurnPortMaximum; port++) {
+                    AirTurnAnalogPortState *s = &state->ports[port];
+                    if (!s->hasPending || (s->hasSent && s->lastSentTime + intervals[port] > now)) {
+                        continue;
+                    }
+                    if (!first) {
+                        AirTurnEventBufferAppendLiteral(buffer, ",");
+                    }
+                    first = NO;
+                    AirTurnEventBufferAppendLiteral(buffer, "[");
+                    AirTurnEventBufferAppendJSONString(buffer, state.identifier);
+                    AirTurnEventBufferAppendLiteral(buffer, ",");
+                    AirTurnEventBufferAppendInteger(buffer, port);
+                    AirTurnEventBufferAppendLiteral(buffer, ",");
+                    AirTurnEventBufferAppendInteger(buffer, s->pending);
+                    AirTurnEventBufferAppendLiteral(buffer, "]");
+
+                    s->lastSent = s->pending;
+                    s->lastSentTime = now;
+                    s->hasSent = YES;
+                    s->hasPending = NO;
+                }
+            }
+            AirTurnEventBufferAppendLiteral(buffer, "]}");
+        }];
+    }
+
+    if (next != UINT64_MAX) {
+        [self scheduleFrameAt:next now:now];
+    }
+}
+
+@end
@@ -0,0 +1,55 @@
+//
+//  AirTurnCommandTimings.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+#import "AirTurnLatencyStats.h"
+
+/**
+ How long each plugin command spends running. A command is timed once on the main thread, where Cordova calls it, under its name, and once more for the work it hands off, under `<name>.background`.
+
+ All methods are thread safe.
+ */
+@interface AirTurnCommandTimings : NSObject
+
+/**
+ Record one run of a command
+
+ @param command The command (action) name, or `<name>.background` for the work it handed off
+ @param nanoseconds How long it ran
+ */
+- (void)recordCommand:(nonnull NSString *)command nanoseconds:(uint64_t)nanoseconds;
+
+/**
+ The timings of every command run since the last reset, keyed by command name. Each has the keys `count`, `total` and `max`, in milliseconds.
+ */
+- (nonnull NSDictionary *)dictionaryRepresentation;
+
+- (void)reset;
+
+@end
+
+/**
+ A running command, recorded when it goes out of scope. See `AirTurnTimeCommand`.
+ */
+typedef struct {
+    __unsafe_unretained AirTurnCommandTimings * _Nullable timings;
+    __unsafe_unretained NSString * _Nullable command;
+    uint64_t start;
+} AirTurnCommandTiming;
+
+FOUNDATION_EXTERN void AirTurnCommandTimingEnd(AirTurnCommandTiming * _Nonnull timing);
+
+/**
+ Times the rest of the enclosing scope, early returns included, as a run of `command`. Both must outlive the scope.
+ */
+#define AirTurnTimeCommand(timings, command) \
+    __attribute__((cleanup(AirTurnCommandTimingEnd), unused)) AirTurnCommandTiming _commandTiming = { (timings), (command), AirTurnLatencyNow() }
+
+/**
+ Times the rest of the enclosing scope as the work `command` handed off, under `<command>.background`. Use it once per command, in the block that answers.
+ */
+#define AirTurnTimeBackgroundCommand(timings, command) \
+    NSString *_backgroundCommand = [(command) stringByAppendingString:@".background"]; \
+    AirTurnTimeCommand(timings, _backgroundCommand)
@@ -0,0 +1,90 @@
+//
+//  AirTurnCommandTimings.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnCommandTimings.h"
+
+typedef struct {
+    uint64_t count;
+    uint64_t total;
+    uint64_t max;
+} AirTurnCommandCounter;
+
+static NSDictionary *DictionaryForCounter(AirTurnCommandCounter counter)
+{
+    return @{
+             @"count": @(counter.count),
+             @"total": @((double)counter.total / NSEC_PER_MSEC),
+             @"max": @((double)counter.max / NSEC_PER_MSEC)
+             };
+}
+
+static void RecordCounter(AirTurnCommandCounter *counter, uint64_t nanoseconds)
+{
+    counter->count++;
+    counter->total += nanoseconds;
+    counter->max = MAX(counter->max, nanoseconds);
+}
+
+void AirTurnCommandTimingEnd(AirTurnCommandTiming *timing)
+{
+    uint64_t now = AirTurnLatencyNow();
+    [timing->timings recordCommand:timing->command nanoseconds:now > timing->start ? now - timing->start : 0];
+}
+
+@interface AirTurnCommandTimings()
+
+// command name -> counter
+@property(nonatomic, strong) NSMutableDictionary<NSString *, NSMutableData *> *counters;
+
+@end
+
+@implementation AirTurnCommandTimings
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _counters = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)recordCommand:(NSString *)command nanoseconds:(uint64_t)nanoseconds
+{
+    if (!command) {
+        return;
+    }
+
+    @synchronized(self) {
+        NSMutableData *data = self.counters[command];
+        if (!data) {
+            data = [NSMutableData dataWithLength:sizeof(AirTurnCommandCounter)];
+            self.counters[command] = data;
+        }
+        RecordCounter(data.mutableBytes, nanoseconds);
+    }
+}
+
+- (NSDictionary *)dictionaryRepresentation
+{
+    NSMutableDictionary *timings = [NSMutableDictionary dictionary];
+
+    @synchronized(self) {
+        [self.counters enumerateKeysAndObjectsUsingBlock:^(NSString *command, NSMutableData *data, BOOL *stop) {
+            timings[command] = DictionaryForCounter(*(const AirTurnCommandCounter *)data.bytes);
+        }];
+    }
+
+    return timings;
+}
+
+- (void)reset
+{
+    @synchronized(self) {
+        [self.counters removeAllObjects];
+    }
+}
+
+@end
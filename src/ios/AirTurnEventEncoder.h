@@ -0,0 +1,118 @@
+//
+//  AirTurnEventEncoder.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ A growable UTF-8 byte buffer. Encoders append to it in place so that building an event payload does not allocate once the buffer has grown to its working size.
+ */
+typedef struct {
+    char * _Nullable bytes;
+    size_t length;
+    size_t capacity;
+} AirTurnEventBuffer;
+
+FOUNDATION_EXTERN void AirTurnEventBufferInit(AirTurnEventBuffer * _Nonnull buffer, size_t capacity);
+FOUNDATION_EXTERN void AirTurnEventBufferFree(AirTurnEventBuffer * _Nonnull buffer);
+FOUNDATION_EXTERN void AirTurnEventBufferAppend(AirTurnEventBuffer * _Nonnull buffer, const char * _Nonnull bytes, size_t length);
+FOUNDATION_EXTERN void AirTurnEventBufferAppendInteger(AirTurnEventBuffer * _Nonnull buffer, long long value);
+/**
+ Appends `string` as a quoted JSON string literal, escaped so it is also safe inside evaluated JS source
+ */
+FOUNDATION_EXTERN void AirTurnEventBufferAppendJSONString(AirTurnEventBuffer * _Nonnull buffer, NSString * _Nullable string);
+/**
+ Returns the buffer contents as a string. The buffer is left untouched.
+ */
+FOUNDATION_EXTERN NSString * _Nonnull AirTurnEventBufferCopyString(const AirTurnEventBuffer * _Nonnull buffer);
+
+#define AirTurnEventBufferAppendLiteral(buffer, literal) AirTurnEventBufferAppend((buffer), (literal), sizeof(literal) - 1)
+
+/**
+ User info keys read by the encoders when a notification carries no `AirTurnPeripheralKey`, as replayed sessions don't: the peripheral identifier, and the analog value, battery level or charging state
+ */
+FOUNDATION_EXTERN NSString * _Nonnull const AirTurnEventPeripheralIdentifierKey;
+FOUNDATION_EXTERN NSString * _Nonnull const AirTurnEventValueKey;
+
+/**
+ The payload layouts known to the encoder table
+ */
+typedef NS_ENUM(NSInteger, AirTurnEventKind) {
+    /**
+     Any other notification, encoded with `NSJSONSerialization`
+     */
+    AirTurnEventKindGeneric = 0,
+    AirTurnEventKindPedalPress,
+    AirTurnEventKindPedalDown,
+    AirTurnEventKindPedalUp,
+    AirTurnEventKindConnectionState,
+    AirTurnEventKindBatteryLevel,
+    AirTurnEventKindChargingState,
+    AirTurnEventKindAnalogValue
+};
+
+/**
+ Which lane of the event queue an event travels in
+ */
+typedef NS_ENUM(NSInteger, AirTurnEventPriority) {
+    /**
+     Pedal, gesture and analog input, and any event not known to be a status update
+     */
+    AirTurnEventPriorityInput = 0,
+    /**
+     Connection, battery, charging, name, mode and pairing updates. Only the latest per peripheral matters.
+     */
+    AirTurnEventPriorityStatus
+};
+
+/**
+ Encodes one notification type as a `[eventId,{...}]` JSON element.
+
+ Encoders are looked up once per event name, when a listener is added, so the per-event path does no string comparison, builds no temporary dictionaries and does not use `NSJSONSerialization` for the known event kinds.
+
+ Events cross the bridge by numeric ID rather than by name. The AirTurnTypes.h notifications, the keyboard notifications and the plugin's own events have stable IDs from a fixed table; any other name is sent as its name string, `["name",{...}]`. `airturn.js` learns the ID of each event it listens to when it subscribes, and routes by index from then on.
+ */
+@interface AirTurnEventEncoder : NSObject
+
+/**
+ Returns the shared encoder for a notification name. Unknown names get a generic encoder.
+
+ @param eventName The notification name
+ @return The encoder
+ */
++ (nonnull AirTurnEventEncoder *)encoderForEventName:(nonnull NSString *)eventName;
+
+/**
+ Every name in the fixed table, by the ID it is sent as
+ */
++ (nonnull NSDictionary<NSString *, NSNumber *> *)eventIds;
+
+@property(nonatomic, readonly, nonnull) NSString *eventName;
+
+/**
+ The number the event is sent as, the same in every release, or `NSNotFound` for a name outside the table, which is sent by name
+ */
+@property(nonatomic, readonly) NSUInteger eventId;
+
+@property(nonatomic, readonly) AirTurnEventKind kind;
+
+@property(nonatomic, readonly) AirTurnEventPriority priority;
+
+/**
+ Append the `[eventId,{...}]` element for a notification
+
+ @param userInfo The notification user info
+ @param buffer The buffer to append to
+ */
+- (void)encodeUserInfo:(nullable NSDictionary *)userInfo intoBuffer:(nonnull AirTurnEventBuffer *)buffer;
+
+/**
+ Append a `[eventId,...]` element whose data is written by the caller, for events the plugin synthesises itself
+
+ @param payload Appends the event data as one JSON value
+ @param buffer The buffer to append to
+ */
+- (void)encodePayload:(nonnull void (^)(AirTurnEventBuffer * _Nonnull buffer))payload intoBuffer:(nonnull AirTurnEventBuffer *)buffer;
+
+@end
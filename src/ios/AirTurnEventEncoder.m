@@ -0,0 +1,393 @@
+//
+//  AirTurnEventEncoder.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnEventEncoder.h"
+#import "AirTurnAnalogStreamer.h"
+#import "AirTurnGestureEngine.h"
+#import "AirTurnRepeatCoalescer.h"
+#import <AirTurnInterface/AirTurnInterface.h>
+
+NSString * const AirTurnEventPeripheralIdentifierKey = @"AirTurnEventPeripheralIdentifier";
+NSString * const AirTurnEventValueKey = @"AirTurnEventValue";
+
+#pragma mark - Buffer
+
+void AirTurnEventBufferInit(AirTurnEventBuffer *buffer, size_t capacity)
+{
+    buffer->bytes = malloc(capacity);
+    buffer->length = 0;
+    buffer->capacity = buffer->bytes ? capacity : 0;
+}
+
+void AirTurnEventBufferFree(AirTurnEventBuffer *buffer)
+{
+    free(buffer->bytes);
+    buffer->bytes = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
+
+static void AirTurnEventBufferReserve(AirTurnEventBuffer *buffer, size_t additional)
+{
+    size_t required = buffer->length + additional;
+    if (required <= buffer->capacity) {
+        return;
+    }
+    size_t capacity = buffer->capacity ? buffer->capacity : 256;
+    while (capacity < required) {
+        capacity *= 2;
+    }
+    char *bytes = realloc(buffer->bytes, capacity);
+    if (!bytes) {
+        @throw [NSException exceptionWithName:NSMallocException reason:@"AirTurn event buffer allocation failed" userInfo:nil];
+    }
+    buffer->bytes = bytes;
+    buffer->capacity = capacity;
+}
+
+void AirTurnEventBufferAppend(AirTurnEventBuffer *buffer, const char *bytes, size_t length)
+{
+    AirTurnEventBufferReserve(buffer, length);
+    memcpy(buffer->bytes + buffer->length, bytes, length);
+    buffer->length += length;
+}
+
+void AirTurnEventBufferAppendInteger(AirTurnEventBuffer *buffer, long long value)
+{
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    char *p = end;
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    do {
+        *--p = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) {
+        *--p = '-';
+    }
+    AirTurnEventBufferAppend(buffer, p, (size_t)(end - p));
+}
+
+void AirTurnEventBufferAppendJSONString(AirTurnEventBuffer *buffer, NSString *string)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    if (!string) {
+        AirTurnEventBufferAppendLiteral(buffer, "null");
+        return;
+    }
+
+    const char *utf8 = CFStringGetCStringPtr((__bridge CFStringRef)string, kCFStringEncodingUTF8);
+    if (!utf8) {
+        utf8 = [string UTF8String];
+    }
+    size_t length = strlen(utf8);
+
+    // worst case every byte becomes a 6 byte \u escape
+    AirTurnEventBufferReserve(buffer, length * 6 + 2);
+    char *out = buffer->bytes + buffer->length;
+    *out++ = '"';
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)utf8[i];
+        if (c == '"' || c == '\\') {
+            *out++ = '\\';
+            *out++ = (char)c;
+        } else if (c < 0x20) {
+            *out++ = '\\'; *out++ = 'u'; *out++ = '0'; *out++ = '0';
+            *out++ = hex[c >> 4]; *out++ = hex[c & 0xf];
+        } else if (c == 0xe2 && i + 2 < length && (unsigned char)utf8[i + 1] == 0x80 && ((unsigned char)utf8[i + 2] == 0xa8 || (unsigned char)utf8[i + 2] == 0xa9)) {
+            // U+2028/U+2029 are valid JSON but terminate string literals in evaluated JS
+            *out++ = '\\'; *out++ = 'u'; *out++ = '2'; *out++ = '0'; *out++ = '2';
+            *out++ = (unsigned char)utf8[i + 2] == 0xa8 ? '8' : '9';
+            i += 2;
+        } else {
+            *out++ = (char)c;
+        }
+    }
+    *out++ = '"';
+    buffer->length = (size_t)(out - buffer->bytes);
+}
+
+NSString *AirTurnEventBufferCopyString(const AirTurnEventBuffer *buffer)
+{
+    if (buffer->length == 0) {
+        return @"";
+    }
+    return [[NSString alloc] initWithBytes:buffer->bytes length:buffer->length encoding:NSUTF8StringEncoding];
+}
+
+#pragma mark - Encoders
+
+typedef void (*AirTurnEventEncodeFunction)(AirTurnEventBuffer *buffer, NSDictionary *userInfo);
+
+static void EncodePedalPress(AirTurnEventBuffer *buffer, NSDictionary *userInfo)
+{
+    AirTurnEventBufferAppendLiteral(buffer, "{\"AirTurnPortNumberKey\":");
+    AirTurnEventBufferAppendInteger(buffer, [userInfo[AirTurnPortNumberKey] integerValue]);
+    AirTurnEventBufferAppendLiteral(buffer, "}");
+}
+
+static void EncodePedalState(AirTurnEventBuffer *buffer, NSDictionary *userInfo)
+{
+    AirTurnEventBufferAppendLiteral(buffer, "{\"AirTurnPortNumberKey\":");
+    AirTurnEventBufferAppendInteger(buffer, [userInfo[AirTurnPortNumberKey] integerValue]);
+    AirTurnEventBufferAppendLiteral(buffer, ",\"AirTurnPortStateKey\":");
+    AirTurnEventBufferAppendInteger(buffer, [userInfo[AirTurnPortStateKey] integerValue]);
+    AirTurnEventBufferAppendLiteral(buffer, "}");
+}
+
+static void EncodeConnectionState(AirTurnEventBuffer *buffer, NSDictionary *userInfo)
+{
+    AirTurnEventBufferAppendLiteral(buffer, "{\"AirTurnConnectionStateKey\":");
+    AirTurnEventBufferAppendInteger(buffer, [userInfo[AirTurnConnectionStateKey] integerValue]);
+    AirTurnEventBufferAppendLiteral(buffer, "}");
+}
+
+static void EncodeBatteryLevel(AirTurnEventBuffer *buffer, NSDictionary *userInfo)
+{
+    AirTurnPeripheral *p = userInfo[AirTurnPeripheralKey];
+    AirTurnEventBufferAppendLiteral(buffer, "{\"AirTurnIDKey\":");
+    AirTurnEventBufferAppendJSONString(buffer, p ? p.identifier : userInfo[AirTurnEventPeripheralIdentifierKey]);
+    AirTurnEventBufferAppendLiteral(buffer, ",\"batteryLevel\":");
+    AirTurnEventBufferAppendInteger(buffer, p ? p.batteryLevel : [userInfo[AirTurnEventValueKey] integerValue]);
+    AirTurnEventBufferAppendLiteral(buffer, "}");
+}
+
+static void EncodeChargingState(AirTurnEventBuffer *buffer, NSDictionary *userInfo)
+{
+    AirTurnPeripheral *p = userInfo[AirTurnPeripheralKey];
+    AirTurnEventBufferAppendLiteral(buffer, "{\"AirTurnIDKey\":");
+    AirTurnEventBufferAppendJSONString(buffer, p ? p.identifier : userInfo[AirTurnEventPeripheralIdentifierKey]);
+    AirTurnEventBufferAppendLiteral(buffer, ",\"chargingState\":");
+    AirTurnEventBufferAppendInteger(buffer, p ? p.chargingState : [userInfo[AirTurnEventValueKey] integerValue]);
+    AirTurnEventBufferAppendLiteral(buffer, "}");
+}
+
+static void EncodeAnalogValue(AirTurnEventBuffer *buffer, NSDictionary *userInfo)
+{
+    AirTurnPeripheral *p = userInfo[AirTurnPeripheralKey];
+    AirTurnPort port = [userInfo[AirTurnPortNumberKey] integerValue];
+    AirTurnEventBufferAppendLiteral(buffer, "{\"AirTurnIDKey\":");
+    AirTurnEventBufferAppendJSONString(buffer, p ? p.identifier : userInfo[AirTurnEventPeripheralIdentifierKey]);
+    AirTurnEventBufferAppendLiteral(buffer, ",\"AirTurnPortNumberKey\":");
+    AirTurnEventBufferAppendInteger(buffer, port);
+    AirTurnEventBufferAppendLiteral(buffer, ",\"value\":");
+    AirTurnEventBufferAppendInteger(buffer, p ? [p analogPortValue:port] : [userInfo[AirTurnEventValueKey] integerValue]);
+    AirTurnEventBufferAppendLiteral(buffer, "}");
+}
+
+static void EncodeGeneric(AirTurnEventBuffer *buffer, NSDictionary *userInfo)
+{
+    if (!userInfo) {
+        AirTurnEventBufferAppendLiteral(buffer, "{}");
+        return;
+    }
+
+    NSError *error;
+    NSData *jsonData = [NSJSONSerialization dataWithJSONObject:userInfo
+                                                       options:(NSJSONWritingOptions)0
+                                                         error:&error];
+    if (!jsonData) {
+        @throw [NSException exceptionWithName:@"JSON Serialization exception"
+                                       reason:error.debugDescription
+                                     userInfo:error ? @{ @"NSError" : error } : nil];
+    }
+
+    AirTurnEventBufferAppend(buffer, jsonData.bytes, jsonData.length);
+}
+
+#pragma mark - Encoder
+
+@interface AirTurnEventEncoder() {
+    AirTurnEventBuffer _prefix;
+    AirTurnEventEncodeFunction _encode;
+}
+
+@end
+
+@implementation AirTurnEventEncoder
+
++ (NSDictionary<NSString *, NSNumber *> *)kindTable
+{
+    static NSDictionary *table;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        table = @{
+                  AirTurnPedalPressNotification: @(AirTurnEventKindPedalPress),
+                  AirTurnPedalDownNotification: @(AirTurnEventKindPedalDown),
+                  AirTurnPedalUpNotification: @(AirTurnEventKindPedalUp),
+                  AirTurnConnectionStateChangedNotification: @(AirTurnEventKindConnectionState),
+                  // name used by existing Javascript clients
+                  @"AirTurnConnectionStateNotification": @(AirTurnEventKindConnectionState),
+                  AirTurnDidUpdateBatteryLevelNotification: @(AirTurnEventKindBatteryLevel),
+                  AirTurnDidUpdateChargingStateNotification: @(AirTurnEventKindChargingState),
+                  AirTurnAnalogPortValueChangeNotification: @(AirTurnEventKindAnalogValue)
+                  };
+    });
+    return table;
+}
+
+/**
+ * The event ID table: the AirTurnTypes.h notifications in header order, then
+ * the events the plugin sends itself, then the keyboard notifications. IDs are
+ * indexes into this array, so it is only ever appended to, and a name may only
+ * appear once. "AirTurnConnectionStateNotification", the name existing
+ * Javascript clients listen for, has no slot of its own: it may be the value of
+ * AirTurnConnectionStateChangedNotification, which would make it a second,
+ * unreachable slot, and where it is not it is sent by name.
+**/
++ (NSArray<NSString *> *)eventIdTable
+{
+    static NSArray *table;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        table = @[
+                  AirTurnPedalPressNotification,
+                  AirTurnPedalDownNotification,
+                  AirTurnPedalUpNotification,
+                  AirTurnAnalogPortValueChangeNotification,
+                  AirTurnCentralStateChangedNotification,
+                  AirTurnDiscoveredNotification,
+                  AirTurnLostNotification,
+                  AirTurnConnectingNotification,
+                  AirTurnConnectionStateChangedNotification,
+                  AirTurnDidConnectNotification,
+                  AirTurnDidFailToConnectNotification,
+                  AirTurnDidDisconnectNotification,
+                  AirTurnAddedNotification,
+                  AirTurnRemovedNotification,
+                  AirTurnInvalidatedNotification,
+                  AirTurnWriteCompleteNotification,
+                  AirTurnDidUpdateCurrentModeNotification,
+                  AirTurnDidUpdateNameNotification,
+                  AirTurnDidUpdateChargingStateNotification,
+                  AirTurnDidUpdateBatteryLevelNotification,
+                  AirTurnDidUpdatePairingStateNotification,
+                  AirTurnGestureEvent,
+                  AirTurnPedalRepeatEvent,
+                  AirTurnAnalogFrameEvent,
+                  @"AirTurnReady",
+                  @"AirTurnStatus",
+                  AirTurnAutomaticKeyboardManagementEnabledChangedNotification,
+                  AirTurnVirtualKeyboardWillShowNotification,
+                  AirTurnVirtualKeyboardDidShowNotification,
+                  AirTurnVirtualKeyboardWillHideNotification,
+                  AirTurnVirtualKeyboardDidHideNotification,
+                  AirTurnKeyboardManagerReadyNotification,
+                  AirTurnKeyboardStateMonitorReadyNotification,
+                  AirTurnKeyboardStateMonitorFirstResponderChangedNotification,
+                  AirTurnKeyboardStateMonitorFirstResponderOwnerChangedNotification,
+                  AirTurnKeyboardStateMonitorExternalKeyboardStateChangedNotification,
+                  AirTurnKeyboardStateMonitorVirtualKeyboardShouldBeShownChangedNotification
+                  ];
+        NSAssert([NSSet setWithArray:table].count == table.count, @"A name appears twice in the event ID table");
+    });
+    return table;
+}
+
++ (NSDictionary<NSString *, NSNumber *> *)eventIds
+{
+    NSArray<NSString *> *table = [self eventIdTable];
+    NSMutableDictionary<NSString *, NSNumber *> *ids = [NSMutableDictionary dictionaryWithCapacity:table.count];
+    [table enumerateObjectsUsingBlock:^(NSString *name, NSUInteger eventId, BOOL *stop) {
+        ids[name] = @(eventId);
+    }];
+    return ids;
+}
+
++ (NSSet<NSString *> *)statusEventNames
+{
+    static NSSet *names;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        names = [NSSet setWithObjects:
+                 AirTurnConnectionStateChangedNotification,
+                 @"AirTurnConnectionStateNotification",
+                 AirTurnCentralStateChangedNotification,
+                 AirTurnDidUpdateBatteryLevelNotification,
+                 AirTurnDidUpdateChargingStateNotification,
+                 AirTurnDidUpdateNameNotification,
+                 AirTurnDidUpdateCurrentModeNotification,
+                 AirTurnDidUpdatePairingStateNotification,
+                 nil];
+    });
+    return names;
+}
+
++ (AirTurnEventEncoder *)encoderForEventName:(NSString *)eventName
+{
+    static NSMutableDictionary<NSString *, AirTurnEventEncoder *> *encoders;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        encoders = [[NSMutableDictionary alloc] init];
+    });
+
+    @synchronized(encoders) {
+        AirTurnEventEncoder *encoder = encoders[eventName];
+        if (!encoder) {
+            // names outside the table have no ID and are sent by name
+            NSUInteger eventId = [[self eventIdTable] indexOfObject:eventName];
+
+            AirTurnEventKind kind = [[self kindTable][eventName] integerValue];
+            AirTurnEventPriority priority = [[self statusEventNames] containsObject:eventName] ? AirTurnEventPriorityStatus : AirTurnEventPriorityInput;
+            encoder = [[AirTurnEventEncoder alloc] initWithEventName:eventName eventId:eventId kind:kind priority:priority];
+            encoders[eventName] = encoder;
+        }
+        return encoder;
+    }
+}
+
+- (instancetype)initWithEventName:(NSString *)eventName eventId:(NSUInteger)eventId kind:(AirTurnEventKind)kind priority:(AirTurnEventPriority)priority
+{
+    self = [super init];
+    if (self) {
+        _eventName = [eventName copy];
+        _eventId = eventId;
+        _kind = kind;
+        _priority = priority;
+        switch (kind) {
+            case AirTurnEventKindPedalPress: _encode = EncodePedalPress; break;
+            case AirTurnEventKindPedalDown:
+            case AirTurnEventKindPedalUp: _encode = EncodePedalState; break;
+            case AirTurnEventKindConnectionState: _encode = EncodeConnectionState; break;
+            case AirTurnEventKindBatteryLevel: _encode = EncodeBatteryLevel; break;
+            case AirTurnEventKindChargingState: _encode = EncodeChargingState; break;
+            case AirTurnEventKindAnalogValue: _encode = EncodeAnalogValue; break;
+            case AirTurnEventKindGeneric: _encode = EncodeGeneric; break;
+        }
+
+        // the `[eventId,` prefix never changes, so encode it once
+        AirTurnEventBufferInit(&_prefix, 24);
+        AirTurnEventBufferAppendLiteral(&_prefix, "[");
+        if (eventId == NSNotFound) {
+            AirTurnEventBufferAppendJSONString(&_prefix, eventName);
+        } else {
+            AirTurnEventBufferAppendInteger(&_prefix, (long long)eventId);
+        }
+        AirTurnEventBufferAppendLiteral(&_prefix, ",");
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    AirTurnEventBufferFree(&_prefix);
+}
+
+- (void)encodeUserInfo:(NSDictionary *)userInfo intoBuffer:(AirTurnEventBuffer *)buffer
+{
+    AirTurnEventBufferAppend(buffer, _prefix.bytes, _prefix.length);
+    _encode(buffer, userInfo);
+    AirTurnEventBufferAppendLiteral(buffer, "]");
+}
+
+- (void)encodePayload:(void (^)(AirTurnEventBuffer *))payload intoBuffer:(AirTurnEventBuffer *)buffer
+{
+    AirTurnEventBufferAppend(buffer, _prefix.bytes, _prefix.length);
+    payload(buffer);
+    AirTurnEventBufferAppendLiteral(buffer, "]");
+}
+
+@end
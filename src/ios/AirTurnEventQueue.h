@@ -0,0 +1,117 @@
+//
+//  AirTurnEventQueue.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+#import "AirTurnEventEncoder.h"
+#import "AirTurnLatencyStats.h"
+
+@protocol AirTurnEventQueueDelegate;
+
+/**
+ Collects events destined for the WebView and delivers them as a single batch.
+
+ Events enqueued within one coalescing window are encoded straight into one reusable byte buffer as a JSON array of `[eventId, data]` pairs, so a burst of pedal presses costs one bridge crossing instead of one per event. All methods must be called on the queue passed to the initialiser.
+
+ Events travel in two lanes. Input events are delivered in order within one coalescing window. Status events (`AirTurnEventPriorityStatus`) keep only the latest per event name and peripheral, wait up to `statusCoalescingInterval`, and are placed after the input events of the batch they go out with, so input never waits behind status.
+ */
+@interface AirTurnEventQueue : NSObject
+
+/**
+ The delegate that receives each flushed batch
+ */
+@property(nonatomic, weak, nullable) id<AirTurnEventQueueDelegate> delegate;
+
+/**
+ How long to wait after the first queued event before flushing, in seconds. Default is one display frame (1/60 s). Set to 0 to flush on the next run loop turn.
+ */
+@property(nonatomic, assign) NSTimeInterval coalescingInterval;
+
+/**
+ How long a status event may wait for a batch, in seconds. Default 0.1 s. Status events go out sooner with any input event.
+ */
+@property(nonatomic, assign) NSTimeInterval statusCoalescingInterval;
+
+/**
+ Number of events waiting for the next flush, in both lanes
+ */
+@property(nonatomic, readonly) NSUInteger count;
+
+/**
+ Most batches delivered but not yet acknowledged by Javascript before delivery is held back. Default 4, 0 to never hold back.
+
+ While held back, input events accumulate and status events keep merging latest-only, until an acknowledgement arrives or one second passes without one. Backpressure only applies once Javascript has acknowledged a batch, so pages that never acknowledge are not throttled.
+ */
+@property(nonatomic, assign) NSUInteger highWaterMark;
+
+/**
+ Batches delivered but not yet acknowledged
+ */
+@property(nonatomic, readonly) NSUInteger inFlight;
+
+/**
+ When set, the time each event waits between being encoded and its batch being flushed is recorded as `AirTurnLatencyStageCoalesce`
+ */
+@property(nonatomic, strong, nullable) AirTurnLatencyStats *latencyStats;
+
+/**
+ The serial queue the event queue is confined to. Flushes and delegate callbacks happen on it.
+ */
+@property(nonatomic, readonly, nonnull) dispatch_queue_t queue;
+
+- (nonnull instancetype)initWithQueue:(nonnull dispatch_queue_t)queue delegate:(nullable id<AirTurnEventQueueDelegate>)delegate;
+
+/**
+ Queue an event for delivery, in the lane of the encoder's priority
+
+ @param encoder The encoder for the event type, its event ID identifies the event to Javascript
+ @param userInfo The notification user info to encode
+ */
+- (void)enqueueEvent:(nonnull AirTurnEventEncoder *)encoder userInfo:(nullable NSDictionary *)userInfo;
+
+/**
+ Queue an input event whose data is written by the caller
+
+ @param encoder The encoder for the event name
+ @param payload Appends the event data as one JSON value
+ */
+- (void)enqueueEvent:(nonnull AirTurnEventEncoder *)encoder payload:(nonnull void (^)(AirTurnEventBuffer * _Nonnull buffer))payload;
+
+/**
+ Deliver any queued events immediately, even past the high-water mark
+ */
+- (void)flush;
+
+/**
+ Record that Javascript has processed batches
+
+ @param delivered The total number of batches Javascript has processed since the last reset
+ */
+- (void)acknowledgeBatches:(NSUInteger)delivered;
+
+/**
+ Depth and drop counters, with the keys `depth` (events waiting), `maxDepth`, `inFlight`, `highWaterMark`, `delivered` (batches), `held` (times delivery was held back at the high-water mark, once per hold however long it lasts) and `superseded` (status events dropped for a newer one). Counters run from when the queue was created.
+ */
+- (nonnull NSDictionary *)statistics;
+
+/**
+ Discard any queued events without delivering them, and forget unacknowledged batches, as when the page reloads
+ */
+- (void)reset;
+
+@end
+
+
+@protocol AirTurnEventQueueDelegate <NSObject>
+
+/**
+ Called on the event queue's `queue` with each batch of events
+
+ @param queue The event queue
+ @param batch A JSON array of `[eventId, data]` pairs
+ @param count The number of events in the batch
+ */
+- (void)eventQueue:(nonnull AirTurnEventQueue *)queue deliverBatch:(nonnull NSString *)batch count:(NSUInteger)count;
+
+@end
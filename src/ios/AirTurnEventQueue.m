@@ -0,0 +1,293 @@
+//
+//  AirTurnEventQueue.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnEventQueue.h"
+#import <AirTurnInterface/AirTurnInterface.h>
+
+static const NSTimeInterval DefaultCoalescingInterval = 1.0 / 60.0;
+static const NSTimeInterval DefaultStatusCoalescingInterval = 0.1;
+static const NSUInteger DefaultHighWaterMark = 4;
+// how long a held flush waits for an acknowledgement before delivering anyway
+static const NSTimeInterval StallInterval = 1.0;
+
+@interface AirTurnEventQueue() {
+    AirTurnEventBuffer _buffer;
+    // AirTurnLatencyNow() at which each queued event was encoded, while latencyStats is set
+    AirTurnEventBuffer _encodedAt;
+    // status events are encoded here first, then kept latest-only by key
+    AirTurnEventBuffer _scratch;
+}
+
+@property(nonatomic, assign) NSUInteger inputCount;
+@property(nonatomic, strong) NSMutableDictionary<NSString *, NSData *> *statusEvents;
+@property(nonatomic, strong) NSMutableArray<NSString *> *statusOrder;
+@property(nonatomic, assign) uint64_t flushDeadline;
+@property(nonatomic, assign) NSUInteger flushGeneration;
+
+@property(nonatomic, assign) BOOL acknowledging;
+// delivery is held back and was counted in heldTotal
+@property(nonatomic, assign) BOOL holding;
+@property(nonatomic, assign) NSUInteger sentBatches;
+@property(nonatomic, assign) NSUInteger acknowledgedBatches;
+@property(nonatomic, assign) uint64_t lastAcknowledgedAt;
+@property(nonatomic, assign) NSUInteger maxDepth;
+@property(nonatomic, assign) unsigned long long deliveredTotal;
+@property(nonatomic, assign) unsigned long long heldTotal;
+@property(nonatomic, assign) unsigned long long supersededTotal;
+
+@end
+
+@implementation AirTurnEventQueue
+
+- (instancetype)initWithQueue:(dispatch_queue_t)queue delegate:(id<AirTurnEventQueueDelegate>)delegate
+{
+    self = [super init];
+    if (self) {
+        _queue = queue;
+        _delegate = delegate;
+        _coalescingInterval = DefaultCoalescingInterval;
+        _statusCoalescingInterval = DefaultStatusCoalescingInterval;
+        _highWaterMark = DefaultHighWaterMark;
+        _statusEvents = [NSMutableDictionary dictionary];
+        _statusOrder = [NSMutableArray array];
+        AirTurnEventBufferInit(&_buffer, 1024);
+        AirTurnEventBufferInit(&_encodedAt, 64 * sizeof(uint64_t));
+        AirTurnEventBufferInit(&_scratch, 256);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    AirTurnEventBufferFree(&_buffer);
+    AirTurnEventBufferFree(&_encodedAt);
+    AirTurnEventBufferFree(&_scratch);
+}
+
+- (NSUInteger)count
+{
+    return self.inputCount + self.statusOrder.count;
+}
+
+- (NSUInteger)inFlight
+{
+    return self.sentBatches - MIN(self.acknowledgedBatches, self.sentBatches);
+}
+
+- (void)enqueueEvent:(AirTurnEventEncoder *)encoder userInfo:(NSDictionary *)userInfo
+{
+    if (encoder.priority == AirTurnEventPriorityStatus) {
+        [self enqueueStatusEvent:encoder userInfo:userInfo];
+        return;
+    }
+
+    size_t mark = [self beginEvent];
+    @try {
+        [encoder encodeUserInfo:userInfo intoBuffer:&_buffer];
+    }
+    @catch (NSException *exception) {
+        // drop the partial element so the rest of the batch stays valid
+        _buffer.length = mark;
+        @throw;
+    }
+    [self commitEvent];
+}
+
+- (void)enqueueEvent:(AirTurnEventEncoder *)encoder payload:(void (^)(AirTurnEventBuffer *))payload
+{
+    size_t mark = [self beginEvent];
+    @try {
+        [encoder encodePayload:payload intoBuffer:&_buffer];
+    }
+    @catch (NSException *exception) {
+        _buffer.length = mark;
+        @throw;
+    }
+    [self commitEvent];
+}
+
+- (size_t)beginEvent
+{
+    size_t mark = _buffer.length;
+    if (self.inputCount == 0) {
+        AirTurnEventBufferAppendLiteral(&_buffer, "[");
+    } else {
+        AirTurnEventBufferAppendLiteral(&_buffer, ",");
+    }
+    return mark;
+}
+
+- (void)commitEvent
+{
+    if (self.latencyStats) {
+        uint64_t now = AirTurnLatencyNow();
+        AirTurnEventBufferAppend(&_encodedAt, (const char *)&now, sizeof(now));
+    }
+
+    self.inputCount++;
+    self.maxDepth = MAX(self.maxDepth, self.count);
+
+    [self scheduleFlushAfter:self.coalescingInterval];
+}
+
+- (void)enqueueStatusEvent:(AirTurnEventEncoder *)encoder userInfo:(NSDictionary *)userInfo
+{
+    // encoded now, so a bad payload still throws to the caller rather than at flush
+    _scratch.length = 0;
+    [encoder encodeUserInfo:userInfo intoBuffer:&_scratch];
+
+    AirTurnPeripheral *p = userInfo[AirTurnPeripheralKey];
+    NSString *identifier = p ? p.identifier : userInfo[AirTurnEventPeripheralIdentifierKey];
+    NSString *key = identifier ? [encoder.eventName stringByAppendingFormat:@"|%@", identifier] : encoder.eventName;
+
+    if (!self.statusEvents[key]) {
+        [self.statusOrder addObject:key];
+        self.maxDepth = MAX(self.maxDepth, self.count);
+    } else {
+        self.supersededTotal++;
+    }
+    self.statusEvents[key] = [NSData dataWithBytes:_scratch.bytes length:_scratch.length];
+
+    [self scheduleFlushAfter:self.statusCoalescingInterval];
+}
+
+- (void)scheduleFlushAfter:(NSTimeInterval)interval
+{
+    uint64_t deadline = AirTurnLatencyNow() + (uint64_t)(MAX(0, interval) * NSEC_PER_SEC);
+
+    // a flush already due sooner picks this event up
+    if (self.flushDeadline != 0 && self.flushDeadline <= deadline) {
+        return;
+    }
+    self.flushDeadline = deadline;
+    NSUInteger generation = ++self.flushGeneration;
+
+    __typeof(self) __weak weakSelf = self;
+    void (^flushBlock)(void) = ^{
+        __typeof(self) __strong strongSelf = weakSelf;
+        if (strongSelf.flushGeneration == generation) {
+            [strongSelf flushUnlessHeld];
+        }
+    };
+
+    if (interval <= 0) {
+        dispatch_async(self.queue, flushBlock);
+    } else {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC)), self.queue, flushBlock);
+    }
+}
+
+- (void)flushUnlessHeld
+{
+    self.flushDeadline = 0;
+
+    if (self.acknowledging && self.highWaterMark > 0 && self.inFlight >= self.highWaterMark) {
+        uint64_t stalledFor = AirTurnLatencyNow() - self.lastAcknowledgedAt;
+        if (stalledFor < (uint64_t)(StallInterval * NSEC_PER_SEC)) {
+            // Javascript is behind; keep collecting, the next acknowledgement flushes
+            if (!self.holding) {
+                self.holding = YES;
+                self.heldTotal++;
+            }
+            [self scheduleFlushAfter:StallInterval - (double)stalledFor / NSEC_PER_SEC];
+            return;
+        }
+        // no acknowledgement for a while, it may have been lost, so let one batch through
+        self.lastAcknowledgedAt = AirTurnLatencyNow();
+    }
+
+    [self flush];
+}
+
+- (void)acknowledgeBatches:(NSUInteger)delivered
+{
+    self.acknowledging = YES;
+    self.acknowledgedBatches = MAX(self.acknowledgedBatches, delivered);
+    self.lastAcknowledgedAt = AirTurnLatencyNow();
+
+    if (self.count > 0 && self.inFlight < self.highWaterMark) {
+        [self scheduleFlushAfter:0];
+    }
+}
+
+- (void)flush
+{
+    // whatever is scheduled is superseded by this flush
+    self.flushDeadline = 0;
+    self.flushGeneration++;
+    self.holding = NO;
+
+    NSUInteger count = self.count;
+    if (count == 0) {
+        return;
+    }
+
+    AirTurnLatencyStats *stats = self.latencyStats;
+    if (stats && _encodedAt.length) {
+        uint64_t now = AirTurnLatencyNow();
+        const uint64_t *encodedAt = (const uint64_t *)(const void *)_encodedAt.bytes;
+        for (size_t i = 0; i < _encodedAt.length / sizeof(uint64_t); i++) {
+            [stats recordStage:AirTurnLatencyStageCoalesce nanoseconds:now - encodedAt[i]];
+        }
+    }
+
+    // status goes after input, so a page turn is never dispatched behind a battery update
+    BOOL first = self.inputCount == 0;
+    for (NSString *key in self.statusOrder) {
+        NSData *event = self.statusEvents[key];
+        if (first) {
+            AirTurnEventBufferAppendLiteral(&_buffer, "[");
+            first = NO;
+        } else {
+            AirTurnEventBufferAppendLiteral(&_buffer, ",");
+        }
+        AirTurnEventBufferAppend(&_buffer, event.bytes, event.length);
+    }
+
+    AirTurnEventBufferAppendLiteral(&_buffer, "]");
+    NSString *batch = AirTurnEventBufferCopyString(&_buffer);
+
+    [self clear];
+
+    self.sentBatches++;
+    self.deliveredTotal++;
+
+    [self.delegate eventQueue:self deliverBatch:batch count:count];
+}
+
+- (void)clear
+{
+    _buffer.length = 0;
+    _encodedAt.length = 0;
+    self.inputCount = 0;
+    [self.statusEvents removeAllObjects];
+    [self.statusOrder removeAllObjects];
+}
+
+- (NSDictionary *)statistics
+{
+    return @{
+             @"depth": @(self.count),
+             @"maxDepth": @(self.maxDepth),
+             @"inFlight": @(self.inFlight),
+             @"highWaterMark": @(self.highWaterMark),
+             @"delivered": @(self.deliveredTotal),
+             @"held": @(self.heldTotal),
+             @"superseded": @(self.supersededTotal)
+             };
+}
+
+- (void)reset
+{
+    [self clear];
+
+    // a new page starts counting its batches from zero
+    self.acknowledging = NO;
+    self.holding = NO;
+    self.sentBatches = 0;
+    self.acknowledgedBatches = 0;
+}
+
+@end
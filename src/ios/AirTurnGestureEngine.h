@@ -0,0 +1,43 @@
+//
+//  AirTurnGestureEngine.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+#import "AirTurnEventQueue.h"
+
+/**
+ The event name of recognised gestures
+ */
+FOUNDATION_EXTERN NSString * _Nonnull const AirTurnGestureEvent;
+
+/**
+ Recognises pedal gestures from `AirTurnPedalDownNotification` and `AirTurnPedalUpNotification`, timed natively with a monotonic clock.
+
+ Each port runs its own state machine, driven by a transition table, and a press of a second port within the chord window of the first turns both into a chord. Gestures are sent as `AirTurnGesture` events:
+
+     {"gesture":"tap"|"doubleTap"|"longPress"|"holdRepeat"|"chord","AirTurnPortNumberKey":<port>}
+
+ `holdRepeat` adds `"repeatCount"` and `chord` adds `"ports"`, the sorted ports pressed together.
+ */
+@interface AirTurnGestureEngine : NSObject
+
+/**
+ @param eventQueue The event queue gestures are sent through. The engine runs on its queue.
+ @param notificationCenter The center pedal down and up notifications are observed on, the plugin's
+ @param notificationQueue The operation queue notifications are observed on, which must run on the event queue's queue
+ */
+- (nonnull instancetype)initWithEventQueue:(nonnull AirTurnEventQueue *)eventQueue notificationCenter:(nonnull NSNotificationCenter *)notificationCenter notificationQueue:(nonnull NSOperationQueue *)notificationQueue;
+
+@property(nonatomic, readonly) BOOL recognizing;
+
+/**
+ Start recognising, or change the timing of the running engine. All times are in milliseconds.
+
+ @param options `doubleTapInterval`: longest gap between the taps of a double tap, default 300, 0 sends taps straight away without double taps. `longPressDuration`: hold time before a long press, default 500. `repeatInterval`: time between hold repeats after a long press, default 100, 0 for none. `chordWindow`: longest gap between the presses of a chord, default 50, 0 for no chords.
+ */
+- (void)startWithOptions:(nullable NSDictionary *)options;
+
+- (void)stop;
+
+@end
@@ -0,0 +1,331 @@
+//
+//  AirTurnGestureEngine.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnGestureEngine.h"
+#import "AirTurnLatencyStats.h"
+#import <AirTurnInterface/AirTurnInterface.h>
+
+NSString * const AirTurnGestureEvent = @"AirTurnGesture";
+
+typedef NS_ENUM(uint8_t, GestureState) {
+    GestureStateIdle = 0,
+    GestureStatePressed,      // first press down, long press timer armed
+    GestureStateReleased,     // tapped once, double tap timer armed
+    GestureStatePressedAgain, // double tap sent, waiting for release
+    GestureStateHolding,      // long press sent, repeat timer armed
+    GestureStateChorded,      // part of a chord, waiting for release
+    GestureStateCount
+};
+
+typedef NS_ENUM(uint8_t, GestureInput) {
+    GestureInputDown = 0,
+    GestureInputUp,
+    GestureInputTimer,
+    GestureInputChord,
+    GestureInputCount
+};
+
+typedef NS_OPTIONS(uint16_t, GestureAction) {
+    GestureActionNone = 0,
+    GestureActionArmLongPress = 1 << 0,
+    GestureActionArmDoubleTap = 1 << 1,
+    GestureActionArmRepeat = 1 << 2,
+    GestureActionCancelTimer = 1 << 3,
+    GestureActionEmitTap = 1 << 4,
+    GestureActionEmitDoubleTap = 1 << 5,
+    GestureActionEmitLongPress = 1 << 6,
+    GestureActionEmitRepeat = 1 << 7
+};
+
+typedef struct {
+    GestureState next;
+    GestureAction actions;
+} GestureTransition;
+
+/**
+ * Inputs a state doesn't list leave it unchanged and do nothing, e.g. a
+ * repeated down while pressed or a stale timer while idle.
+**/
+static const GestureTransition Transitions[GestureStateCount][GestureInputCount] = {
+    [GestureStateIdle] = {
+        [GestureInputDown] = { GestureStatePressed, GestureActionArmLongPress },
+        [GestureInputUp] = { GestureStateIdle, GestureActionNone },
+        [GestureInputTimer] = { GestureStateIdle, GestureActionNone },
+        [GestureInputChord] = { GestureStateChorded, GestureActionCancelTimer },
+    },
+    [GestureStatePressed] = {
+        [GestureInputDown] = { GestureStatePressed, GestureActionNone },
+        [GestureInputUp] = { GestureStateReleased, GestureActionArmDoubleTap },
+        [GestureInputTimer] = { GestureStateHolding, GestureActionEmitLongPress | GestureActionArmRepeat },
+        [GestureInputChord] = { GestureStateChorded, GestureActionCancelTimer },
+    },
+    [GestureStateReleased] = {
+        [GestureInputDown] = { GestureStatePressedAgain, GestureActionCancelTimer | GestureActionEmitDoubleTap },
+        [GestureInputUp] = { GestureStateReleased, GestureActionNone },
+        [GestureInputTimer] = { GestureStateIdle, GestureActionEmitTap },
+        [GestureInputChord] = { GestureStateReleased, GestureActionNone },
+    },
+    [GestureStatePressedAgain] = {
+        [GestureInputDown] = { GestureStatePressedAgain, GestureActionNone },
+        [GestureInputUp] = { GestureStateIdle, GestureActionNone },
+        [GestureInputTimer] = { GestureStatePressedAgain, GestureActionNone },
+        [GestureInputChord] = { GestureStatePressedAgain, GestureActionNone },
+    },
+    [GestureStateHolding] = {
+        [GestureInputDown] = { GestureStateHolding, GestureActionNone },
+        [GestureInputUp] = { GestureStateIdle, GestureActionCancelTimer },
+        [GestureInputTimer] = { GestureStateHolding, GestureActionEmitRepeat | GestureActionArmRepeat },
+        [GestureInputChord] = { GestureStateHolding, GestureActionNone },
+    },
+    [GestureStateChorded] = {
+        [GestureInputDown] = { GestureStateChorded, GestureActionNone },
+        [GestureInputUp] = { GestureStateIdle, GestureActionNone },
+        [GestureInputTimer] = { GestureStateChorded, GestureActionNone },
+        [GestureInputChord] = { GestureStateChorded, GestureActionNone },
+    },
+};
+
+typedef struct {
+    GestureState state;
+    NSUInteger timerGeneration;
+    uint64_t downAt;
+    NSUInteger repeatCount;
+} GesturePort;
+
+@interface AirTurnGestureEngine() {
+    GesturePort _ports[AirTurnPortMaximum + 1];
+    // nanoseconds, confined to the event queue's queue
+    uint64_t _doubleTapInterval;
+    uint64_t _longPressDuration;
+    uint64_t _repeatInterval;
+    uint64_t _chordWindow;
+}
+
+@property(nonatomic, strong) AirTurnEventQueue *eventQueue;
+@property(nonatomic, strong) NSNotificationCenter *notificationCenter;
+@property(nonatomic, strong) NSOperationQueue *notificationQueue;
+@property(nonatomic, strong) AirTurnEventEncoder *encoder;
+@property(nonatomic, strong) NSArray *observers;
+
+@end
+
+@implementation AirTurnGestureEngine
+
+- (instancetype)initWithEventQueue:(AirTurnEventQueue *)eventQueue notificationCenter:(NSNotificationCenter *)notificationCenter notificationQueue:(NSOperationQueue *)notificationQueue
+{
+    self = [super init];
+    if (self) {
+        _eventQueue = eventQueue;
+        _notificationCenter = notificationCenter;
+        _notificationQueue = notificationQueue;
+        _encoder = [AirTurnEventEncoder encoderForEventName:AirTurnGestureEvent];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    for (id observer in _observers) {
+        [_notificationCenter removeObserver:observer];
+    }
+}
+
+- (BOOL)recognizing
+{
+    return self.observers != nil;
+}
+
+static uint64_t MillisecondsOption(NSDictionary *options, NSString *key, double defaultValue)
+{
+    NSNumber *value = [options[key] isKindOfClass:[NSNumber class]] ? options[key] : nil;
+    return (uint64_t)(MAX(0, value ? [value doubleValue] : defaultValue) * NSEC_PER_MSEC);
+}
+
+- (void)startWithOptions:(NSDictionary *)options
+{
+    uint64_t doubleTapInterval = MillisecondsOption(options, @"doubleTapInterval", 300);
+    uint64_t longPressDuration = MillisecondsOption(options, @"longPressDuration", 500);
+    uint64_t repeatInterval = MillisecondsOption(options, @"repeatInterval", 100);
+    uint64_t chordWindow = MillisecondsOption(options, @"chordWindow", 50);
+
+    dispatch_async(self.eventQueue.queue, ^{
+        self->_doubleTapInterval = doubleTapInterval;
+        self->_longPressDuration = longPressDuration;
+        self->_repeatInterval = repeatInterval;
+        self->_chordWindow = chordWindow;
+    });
+
+    if (!self.observers) {
+        __typeof(self) __weak weakSelf = self;
+        NSNotificationCenter *nc = self.notificationCenter;
+        self.observers = @[
+            [nc addObserverForName:AirTurnPedalDownNotification object:nil queue:self.notificationQueue usingBlock:^(NSNotification *note) {
+                [weakSelf handleInput:GestureInputDown port:[note.userInfo[AirTurnPortNumberKey] integerValue]];
+            }],
+            [nc addObserverForName:AirTurnPedalUpNotification object:nil queue:self.notificationQueue usingBlock:^(NSNotification *note) {
+                [weakSelf handleInput:GestureInputUp port:[note.userInfo[AirTurnPortNumberKey] integerValue]];
+            }]
+        ];
+    }
+}
+
+- (void)stop
+{
+    for (id observer in self.observers) {
+        [self.notificationCenter removeObserver:observer];
+    }
+    self.observers = nil;
+
+    dispatch_async(self.eventQueue.queue, ^{
+        for (AirTurnPort port = AirTurnPortMinimum; port <= AirTurnPortMaximum; port++) {
+            // bumping the generation orphans any armed timer
+            NSUInteger generation = self->_ports[port].timerGeneration + 1;
+            self->_ports[port] = (GesturePort){ .state = GestureStateIdle, .timerGeneration = generation };
+        }
+    });
+}
+
+#pragma mark - Processing queue
+
+- (void)handleInput:(GestureInput)input port:(AirTurnPort)port
+{
+    if (port < AirTurnPortMinimum || port > AirTurnPortMaximum) {
+        return;
+    }
+
+    uint64_t now = AirTurnLatencyNow();
+
+    if (input == GestureInputDown && _ports[port].state == GestureStateIdle && [self chordWithPort:port at:now]) {
+        return;
+    }
+
+    if (input == GestureInputDown) {
+        _ports[port].downAt = now;
+    }
+    [self applyInput:input port:port];
+}
+
+- (void)applyInput:(GestureInput)input port:(AirTurnPort)port
+{
+    GesturePort *p = &_ports[port];
+    GestureTransition transition = Transitions[p->state][input];
+    p->state = transition.next;
+
+    GestureAction actions = transition.actions;
+
+    if (actions & GestureActionCancelTimer) {
+        p->timerGeneration++;
+    }
+    if (actions & GestureActionEmitTap) {
+        [self emitGesture:"tap" port:port repeatCount:0 chordPorts:0];
+    }
+    if (actions & GestureActionEmitDoubleTap) {
+        [self emitGesture:"doubleTap" port:port repeatCount:0 chordPorts:0];
+    }
+    if (actions & GestureActionEmitLongPress) {
+        p->repeatCount = 0;
+        [self emitGesture:"longPress" port:port repeatCount:0 chordPorts:0];
+    }
+    if (actions & GestureActionEmitRepeat) {
+        [self emitGesture:"holdRepeat" port:port repeatCount:++p->repeatCount chordPorts:0];
+    }
+    if (actions & GestureActionArmLongPress) {
+        [self armTimerForPort:port after:_longPressDuration];
+    }
+    if (actions & GestureActionArmDoubleTap) {
+        if (_doubleTapInterval == 0) {
+            // double taps are off, don't hold the tap back waiting for one
+            p->state = GestureStateIdle;
+            p->timerGeneration++;
+            [self emitGesture:"tap" port:port repeatCount:0 chordPorts:0];
+        } else {
+            [self armTimerForPort:port after:_doubleTapInterval];
+        }
+    }
+    if (actions & GestureActionArmRepeat) {
+        if (_repeatInterval == 0) {
+            p->timerGeneration++;
+        } else {
+            [self armTimerForPort:port after:_repeatInterval];
+        }
+    }
+}
+
+/**
+ * A down on an idle port joins every port pressed within the chord window
+ * into one chord. Returns NO when there is nothing to chord with.
+**/
+- (BOOL)chordWithPort:(AirTurnPort)port at:(uint64_t)now
+{
+    if (_chordWindow == 0) {
+        return NO;
+    }
+
+    uint16_t chordPorts = 0;
+    for (AirTurnPort other = AirTurnPortMinimum; other <= AirTurnPortMaximum; other++) {
+        if (other != port && _ports[other].state == GestureStatePressed && now - _ports[other].downAt <= _chordWindow) {
+            chordPorts |= (uint16_t)(1 << other);
+        }
+    }
+    if (chordPorts == 0) {
+        return NO;
+    }
+
+    chordPorts |= (uint16_t)(1 << port);
+    _ports[port].downAt = now;
+    for (AirTurnPort member = AirTurnPortMinimum; member <= AirTurnPortMaximum; member++) {
+        if (chordPorts & (1 << member)) {
+            [self applyInput:GestureInputChord port:member];
+        }
+    }
+
+    [self emitGesture:"chord" port:port repeatCount:0 chordPorts:chordPorts];
+    return YES;
+}
+
+- (void)armTimerForPort:(AirTurnPort)port after:(uint64_t)nanoseconds
+{
+    NSUInteger generation = ++_ports[port].timerGeneration;
+
+    __typeof(self) __weak weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)nanoseconds), self.eventQueue.queue, ^{
+        __typeof(self) __strong strongSelf = weakSelf;
+        if (!strongSelf || strongSelf->_ports[port].timerGeneration != generation) {
+            return;
+        }
+        [strongSelf applyInput:GestureInputTimer port:port];
+    });
+}
+
+- (void)emitGesture:(const char *)gesture port:(AirTurnPort)port repeatCount:(NSUInteger)repeatCount chordPorts:(uint16_t)chordPorts
+{
+    [self.eventQueue enqueueEvent:self.encoder payload:^(AirTurnEventBuffer *buffer) {
+        AirTurnEventBufferAppendLiteral(buffer, "{\"gesture\":\"");
+        AirTurnEventBufferAppend(buffer, gesture, strlen(gesture));
+        AirTurnEventBufferAppendLiteral(buffer, "\",\"AirTurnPortNumberKey\":");
+        AirTurnEventBufferAppendInteger(buffer, port);
+        if (repeatCount) {
+            AirTurnEventBufferAppendLiteral(buffer, ",\"repeatCount\":");
+            AirTurnEventBufferAppendInteger(buffer, (long long)repeatCount);
+        }
+        if (chordPorts) {
+            AirTurnEventBufferAppendLiteral(buffer, ",\"ports\":[");
+            BOOL first = YES;
+            for (AirTurnPort member = AirTurnPortMinimum; member <= AirTurnPortMaximum; member++) {
+                if (chordPorts & (1 << member)) {
+                    if (!first) {
+                        AirTurnEventBufferAppendLiteral(buffer, ",");
+                    }
+                    first = NO;
+                    AirTurnEventBufferAppendInteger(buffer, member);
+                }
+            }
+            AirTurnEventBufferAppendLiteral(buffer, "]");
+        }
+        AirTurnEventBufferAppendLiteral(buffer, "}");
+    }];
+}
+
+@end
@@ -0,0 +1,71 @@
+//
+//  AirTurnLatencyStats.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ The stages an event passes through between the pedal notification and the Javascript listeners
+ */
+typedef NS_ENUM(NSInteger, AirTurnLatencyStage) {
+    /**
+     Notification received on the processing queue to event encoded, per event
+     */
+    AirTurnLatencyStageEncode = 0,
+    /**
+     Event encoded to its batch flushed, per event. Includes the coalescing window.
+     */
+    AirTurnLatencyStageCoalesce,
+    /**
+     Batch flushed to handed to the bridge on the main thread, per batch
+     */
+    AirTurnLatencyStageHandOff,
+    /**
+     Handed to the bridge to received by `airturn.js`, per batch. Measured with the wall clock, only while latency tracking is enabled.
+     */
+    AirTurnLatencyStageBridge,
+    /**
+     Received by `airturn.js` to all listeners returned, per batch. Only while latency tracking is enabled.
+     */
+    AirTurnLatencyStageDispatch,
+    AirTurnLatencyStageCount
+};
+
+/**
+ Monotonic time in nanoseconds, the clock all native stage timestamps use
+ */
+FOUNDATION_EXTERN uint64_t AirTurnLatencyNow(void);
+
+/**
+ Per-stage latency histograms.
+
+ Recording is lock-free (relaxed atomic counters in log-linear buckets with 1/8 relative precision), so it can be called from any thread on the event path. Reading and resetting are not atomic with respect to concurrent recording; a sample recorded during either may be partly counted.
+ */
+@interface AirTurnLatencyStats : NSObject
+
+/**
+ Record one sample
+
+ @param stage The stage
+ @param nanoseconds The time the stage took
+ */
+- (void)recordStage:(AirTurnLatencyStage)stage nanoseconds:(uint64_t)nanoseconds;
+
+/**
+ Record the time from `start` until now
+
+ @param stage The stage
+ @param start A timestamp from `AirTurnLatencyNow()`
+ @return The current time, to use as the start of the next stage
+ */
+- (uint64_t)recordStage:(AirTurnLatencyStage)stage since:(uint64_t)start;
+
+/**
+ The statistics of every stage, keyed by stage name (`encode`, `coalesce`, `handOff`, `bridge`, `dispatch`). Each has the keys `count`, `mean`, `p50`, `p95`, `p99` and `max`, in milliseconds.
+ */
+- (nonnull NSDictionary *)dictionaryRepresentation;
+
+- (void)reset;
+
+@end
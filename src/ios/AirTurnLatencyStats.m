@@ -0,0 +1,144 @@
+//
+//  AirTurnLatencyStats.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnLatencyStats.h"
+#include <stdatomic.h>
+#include <time.h>
+
+// values are kept in microseconds: 8 linear sub-buckets per power of two, up to 2^40 us
+#define SubBucketBits 3
+#define SubBucketCount (1 << SubBucketBits)
+#define MaximumValue ((1ULL << 40) - 1)
+#define BucketCount (((40 - SubBucketBits) * SubBucketCount) + SubBucketCount)
+
+typedef struct {
+    _Atomic uint64_t buckets[BucketCount];
+    _Atomic uint64_t sum;
+    _Atomic uint64_t max;
+} AirTurnLatencyHistogram;
+
+uint64_t AirTurnLatencyNow(void)
+{
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+static unsigned BucketForValue(uint64_t value)
+{
+    if (value < 2 * SubBucketCount) {
+        return (unsigned)value;
+    }
+    unsigned shift = (unsigned)(63 - __builtin_clzll(value)) - SubBucketBits;
+    return shift * SubBucketCount + (unsigned)(value >> shift);
+}
+
+static uint64_t UpperBoundOfBucket(unsigned bucket)
+{
+    if (bucket < 2 * SubBucketCount) {
+        return bucket;
+    }
+    unsigned shift = (bucket - SubBucketCount) / SubBucketCount;
+    uint64_t mantissa = (bucket - SubBucketCount) % SubBucketCount + SubBucketCount;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+static NSString * const StageNames[AirTurnLatencyStageCount] = {
+    @"encode", @"coalesce", @"handOff", @"bridge", @"dispatch"
+};
+
+@interface AirTurnLatencyStats() {
+    AirTurnLatencyHistogram _histograms[AirTurnLatencyStageCount];
+}
+
+@end
+
+@implementation AirTurnLatencyStats
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        [self reset];
+    }
+    return self;
+}
+
+- (void)recordStage:(AirTurnLatencyStage)stage nanoseconds:(uint64_t)nanoseconds
+{
+    if (stage < 0 || stage >= AirTurnLatencyStageCount) {
+        return;
+    }
+    AirTurnLatencyHistogram *h = &_histograms[stage];
+    uint64_t value = MIN(nanoseconds / NSEC_PER_USEC, MaximumValue);
+
+    atomic_fetch_add_explicit(&h->buckets[BucketForValue(value)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum, value, memory_order_relaxed);
+
+    uint64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+    while (value > max && !atomic_compare_exchange_weak_explicit(&h->max, &max, value, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+- (uint64_t)recordStage:(AirTurnLatencyStage)stage since:(uint64_t)start
+{
+    uint64_t now = AirTurnLatencyNow();
+    [self recordStage:stage nanoseconds:now > start ? now - start : 0];
+    return now;
+}
+
+static NSDictionary *DictionaryForHistogram(AirTurnLatencyHistogram *h)
+{
+    uint64_t buckets[BucketCount];
+    uint64_t total = 0;
+    for (unsigned i = 0; i < BucketCount; i++) {
+        buckets[i] = atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+        total += buckets[i];
+    }
+    uint64_t sum = atomic_load_explicit(&h->sum, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+
+    static const double quantiles[] = { 0.50, 0.95, 0.99 };
+    double values[3] = { 0, 0, 0 };
+    uint64_t seen = 0;
+    unsigned q = 0;
+    for (unsigned i = 0; i < BucketCount && q < 3 && total > 0; i++) {
+        seen += buckets[i];
+        while (q < 3 && seen >= (uint64_t)ceil(quantiles[q] * total)) {
+            // never report a percentile above the true maximum
+            values[q++] = MIN(UpperBoundOfBucket(i), max) / 1000.0;
+        }
+    }
+
+    return @{
+             @"count": @(total),
+             @"mean": @(total ? (double)sum / total / 1000.0 : 0),
+             @"p50": @(values[0]),
+             @"p95": @(values[1]),
+             @"p99": @(values[2]),
+             @"max": @(max / 1000.0)
+             };
+}
+
+- (NSDictionary *)dictionaryRepresentation
+{
+    NSMutableDictionary *stats = [NSMutableDictionary dictionaryWithCapacity:AirTurnLatencyStageCount];
+    for (NSInteger stage = 0; stage < AirTurnLatencyStageCount; stage++) {
+        stats[StageNames[stage]] = DictionaryForHistogram(&_histograms[stage]);
+    }
+    return stats;
+}
+
+- (void)reset
+{
+    for (NSInteger stage = 0; stage < AirTurnLatencyStageCount; stage++) {
+        AirTurnLatencyHistogram *h = &_histograms[stage];
+        for (unsigned i = 0; i < BucketCount; i++) {
+            atomic_store_explicit(&h->buckets[i], 0, memory_order_relaxed);
+        }
+        atomic_store_explicit(&h->sum, 0, memory_order_relaxed);
+        atomic_store_explicit(&h->max, 0, memory_order_relaxed);
+    }
+}
+
+@end
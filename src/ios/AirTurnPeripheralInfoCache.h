@@ -0,0 +1,53 @@
+//
+//  AirTurnPeripheralInfoCache.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+#import <AirTurnInterface/AirTurnInterface.h>
+
+/**
+ In-memory store of the name, identifier and firmware/hardware versions of every AirTurn that reached the ready state, keyed by peripheral identifier.
+
+ Lookups never touch `NSUserDefaults`. Changed entries are written behind on a background queue, a short while after the last change or when the App enters the background. The last ready peripheral is also written to the `PeripheralName`, `DeviceUniqueIdentifier`, `FirmwareVersion` and `HardwareVersion` keys used by earlier versions of the plugin. All methods are thread safe.
+ */
+@interface AirTurnPeripheralInfoCache : NSObject
+
++ (nonnull AirTurnPeripheralInfoCache *)sharedCache;
+
+/**
+ How long to wait after a change before persisting, in seconds. Default 2.
+ */
+@property(nonatomic, assign) NSTimeInterval persistDelay;
+
+/**
+ The identifier of the peripheral that most recently became ready, nil if none ever has
+ */
+@property(nonatomic, copy, readonly, nullable) NSString *lastReadyIdentifier;
+
+/**
+ Record a peripheral that became ready
+
+ @param peripheral The peripheral
+ */
+- (void)peripheralDidBecomeReady:(nonnull AirTurnPeripheral *)peripheral;
+
+/**
+ Info for a peripheral, with the keys `PeripheralName`, `DeviceUniqueIdentifier`, `FirmwareVersion` and `HardwareVersion`. Unknown values are `"Unknown"`.
+
+ @param identifier The peripheral identifier, or nil for the last ready peripheral
+ @return The info dictionary
+ */
+- (nonnull NSDictionary<NSString *, NSString *> *)infoForIdentifier:(nullable NSString *)identifier;
+
+/**
+ Write any changed entries now, without waiting for the delay
+ */
+- (void)persist;
+
+/**
+ Write any changed entries now, and call `completion` on the main queue once written
+ */
+- (void)persistWithCompletion:(nullable void (^)(void))completion;
+
+@end
@@ -0,0 +1,190 @@
+//
+//  AirTurnPeripheralInfoCache.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnPeripheralInfoCache.h"
+#import <UIKit/UIKit.h>
+
+static NSString * const PeripheralInfoUserDefaultKey = @"AirTurnPeripheralInfo";
+
+static NSString * const PeripheralNameKey = @"PeripheralName";
+static NSString * const DeviceUniqueIdentifierKey = @"DeviceUniqueIdentifier";
+static NSString * const FirmwareVersionKey = @"FirmwareVersion";
+static NSString * const HardwareVersionKey = @"HardwareVersion";
+
+static const NSTimeInterval DefaultPersistDelay = 2;
+
+@interface AirTurnPeripheralInfoCache()
+
+@property(nonatomic, strong) NSMutableDictionary<NSString *, NSDictionary *> *entries;
+@property(nonatomic, copy) NSString *lastReadyIdentifier;
+@property(nonatomic, assign) BOOL dirty;
+@property(nonatomic, assign) NSUInteger changeCount;
+@property(nonatomic, strong) dispatch_queue_t persistQueue;
+
+@end
+
+@implementation AirTurnPeripheralInfoCache
+
++ (AirTurnPeripheralInfoCache *)sharedCache
+{
+    static AirTurnPeripheralInfoCache *cache;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        cache = [[AirTurnPeripheralInfoCache alloc] init];
+    });
+    return cache;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _persistDelay = DefaultPersistDelay;
+        _persistQueue = dispatch_queue_create("com.airturn.cordova.peripheralinfo", DISPATCH_QUEUE_SERIAL);
+        dispatch_set_target_queue(_persistQueue, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+
+        // one read at startup, including what older plugin versions stored
+        NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+        _entries = [[defaults dictionaryForKey:PeripheralInfoUserDefaultKey] mutableCopy] ?: [NSMutableDictionary dictionary];
+        _lastReadyIdentifier = [defaults stringForKey:DeviceUniqueIdentifierKey];
+        if (_lastReadyIdentifier && !_entries[_lastReadyIdentifier]) {
+            NSMutableDictionary *legacy = [NSMutableDictionary dictionaryWithCapacity:4];
+            for (NSString *key in @[PeripheralNameKey, DeviceUniqueIdentifierKey, FirmwareVersionKey, HardwareVersionKey]) {
+                id value = [defaults objectForKey:key];
+                if ([value isKindOfClass:[NSString class]]) {
+                    legacy[key] = value;
+                }
+            }
+            _entries[_lastReadyIdentifier] = legacy;
+        }
+
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(applicationDidEnterBackground:) name:UIApplicationDidEnterBackgroundNotification object:nil];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (void)applicationDidEnterBackground:(NSNotification *)note
+{
+    // the write is asynchronous, so keep the App running until it is done rather than losing it to suspension
+    UIApplication *application = [UIApplication sharedApplication];
+    __block UIBackgroundTaskIdentifier task = UIBackgroundTaskInvalid;
+    void (^endTask)(void) = ^{
+        if (task != UIBackgroundTaskInvalid) {
+            [application endBackgroundTask:task];
+            task = UIBackgroundTaskInvalid;
+        }
+    };
+    task = [application beginBackgroundTaskWithName:@"AirTurnPeripheralInfo" expirationHandler:endTask];
+
+    [self persistWithCompletion:endTask];
+}
+
+- (void)peripheralDidBecomeReady:(AirTurnPeripheral *)peripheral
+{
+    NSString *identifier = peripheral.identifier;
+    if (!identifier) {
+        return;
+    }
+
+    NSMutableDictionary *entry = [NSMutableDictionary dictionaryWithCapacity:4];
+    entry[DeviceUniqueIdentifierKey] = identifier;
+    entry[PeripheralNameKey] = peripheral.name;
+    entry[FirmwareVersionKey] = peripheral.firmwareVersion.description;
+    entry[HardwareVersionKey] = peripheral.hardwareVersion.description;
+
+    @synchronized(self) {
+        if ([self.entries[identifier] isEqualToDictionary:entry] && [self.lastReadyIdentifier isEqualToString:identifier]) {
+            // reconnecting the same device, nothing to write
+            return;
+        }
+        self.entries[identifier] = entry;
+        self.lastReadyIdentifier = identifier;
+        self.dirty = YES;
+        self.changeCount++;
+    }
+
+    [self schedulePersist];
+}
+
+- (void)schedulePersist
+{
+    NSUInteger changeCount;
+    @synchronized(self) {
+        changeCount = self.changeCount;
+    }
+
+    // debounce: only the last change in a burst of reconnects writes
+    __typeof(self) __weak weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.persistDelay * NSEC_PER_SEC)), self.persistQueue, ^{
+        __typeof(self) __strong strongSelf = weakSelf;
+        BOOL latest;
+        @synchronized(strongSelf) {
+            latest = strongSelf.changeCount == changeCount;
+        }
+        if (latest) {
+            [strongSelf writeIfDirty];
+        }
+    });
+}
+
+- (void)persist
+{
+    [self persistWithCompletion:nil];
+}
+
+- (void)persistWithCompletion:(void (^)(void))completion
+{
+    dispatch_async(self.persistQueue, ^{
+        [self writeIfDirty];
+
+        if (completion) {
+            dispatch_async(dispatch_get_main_queue(), completion);
+        }
+    });
+}
+
+- (void)writeIfDirty
+{
+    NSDictionary *entries;
+    NSString *lastReadyIdentifier;
+    @synchronized(self) {
+        if (!self.dirty) {
+            return;
+        }
+        entries = [self.entries copy];
+        lastReadyIdentifier = self.lastReadyIdentifier;
+        self.dirty = NO;
+    }
+
+    NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+    [defaults setObject:entries forKey:PeripheralInfoUserDefaultKey];
+
+    NSDictionary *last = lastReadyIdentifier ? entries[lastReadyIdentifier] : nil;
+    for (NSString *key in @[PeripheralNameKey, DeviceUniqueIdentifierKey, FirmwareVersionKey, HardwareVersionKey]) {
+        [defaults setObject:last[key] forKey:key];
+    }
+}
+
+- (NSDictionary<NSString *, NSString *> *)infoForIdentifier:(NSString *)identifier
+{
+    NSDictionary *entry;
+    @synchronized(self) {
+        entry = self.entries[identifier ?: self.lastReadyIdentifier ?: @""];
+    }
+
+    return @{
+             PeripheralNameKey: entry[PeripheralNameKey] ?: @"Unknown",
+             DeviceUniqueIdentifierKey: entry[DeviceUniqueIdentifierKey] ?: @"Unknown",
+             FirmwareVersionKey: entry[FirmwareVersionKey] ?: @"Unknown",
+             HardwareVersionKey: entry[HardwareVersionKey] ?: @"Unknown"
+             };
+}
+
+@end
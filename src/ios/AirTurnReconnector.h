@@ -0,0 +1,34 @@
+//
+//  AirTurnReconnector.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Reconnects to the AirTurns of the last session as early as the plugin loads, rather than waiting for the key window and a scan.
+
+ The last session is persisted whenever an AirTurn becomes ready: the identifiers of the stored AirTurns, and the identifier and connection configuration of the one that became ready. At the next launch `start` enables the central straight away and asks it to connect to those AirTurns, the last ready one first, as soon as Bluetooth is usable. When that AirTurn is ready again with a different connection configuration, the stored one is written back to it, once per launch. AirTurnUI starts the same way it always has, later; connecting twice is harmless.
+
+ Reconnection is only started when AirTurn support was left enabled in AirDirect mode, honouring the `AirTurnUIRestoreState` Info.plist key the same way AirTurnUI does. Must be used on the main queue.
+ */
+@interface AirTurnReconnector : NSObject
+
++ (nonnull AirTurnReconnector *)sharedReconnector;
+
+/**
+ The session read at launch, with the keys `identifiers`, `lastIdentifier` and `connectionConfiguration`, nil if there was none
+ */
+@property(nonatomic, copy, readonly, nullable) NSDictionary *lastSession;
+
+/**
+ Start recording sessions and, if there is a last session, reconnecting to it. Calls after the first do nothing.
+ */
+- (void)start;
+
+/**
+ What happened at launch, in milliseconds: `lastSession`, `attempted` (AirTurns asked to connect), `startedSinceLaunch` (process launch to `start`), and once an AirTurn is ready `timeToReady` (from `start`) and `readySinceLaunch`
+ */
+- (nonnull NSDictionary *)dictionaryRepresentation;
+
+@end
@@ -0,0 +1,220 @@
+//
+//  AirTurnReconnector.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnReconnector.h"
+#import "AirTurnLatencyStats.h"
+#import "AirTurnStartupProfile.h"
+#import <AirTurnInterface/AirTurnInterface.h>
+
+static NSString * const LastSessionUserDefaultKey = @"AirTurnLastSession";
+
+static NSString * const IdentifiersKey = @"identifiers";
+static NSString * const LastIdentifierKey = @"lastIdentifier";
+static NSString * const ConnectionConfigurationKey = @"connectionConfiguration";
+
+// the keys AirTurnUIConnectionController restores its state from
+static NSString * const RestoreStateInfoKey = @"AirTurnUIRestoreState";
+static NSString * const EnabledUserDefaultKey = @"AirTurnEnabled";
+static NSString * const AirDirectModeUserDefaultKey = @"AirTurnAirDirectMode";
+
+@interface AirTurnReconnector()
+
+@property(nonatomic, copy) NSDictionary *lastSession;
+@property(nonatomic, strong) NSMutableDictionary *session;
+@property(nonatomic, strong) NSMutableArray *observers;
+@property(nonatomic, strong) dispatch_queue_t persistQueue;
+@property(nonatomic, assign) BOOL started;
+@property(nonatomic, assign) BOOL waitingForCentral;
+@property(nonatomic, assign) BOOL restoredConfiguration;
+@property(nonatomic, assign) NSUInteger attempted;
+@property(nonatomic, assign) uint64_t startedAt;
+@property(nonatomic, assign) double startedSinceLaunch;
+@property(nonatomic, assign) uint64_t timeToReady;
+@property(nonatomic, assign) double readySinceLaunch;
+
+@end
+
+@implementation AirTurnReconnector
+
++ (AirTurnReconnector *)sharedReconnector
+{
+    static AirTurnReconnector *reconnector;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        reconnector = [[AirTurnReconnector alloc] init];
+    });
+    return reconnector;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _observers = [NSMutableArray array];
+        _persistQueue = dispatch_queue_create("com.airturn.cordova.lastsession", DISPATCH_QUEUE_SERIAL);
+        dispatch_set_target_queue(_persistQueue, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+
+        NSDictionary *lastSession = [[NSUserDefaults standardUserDefaults] dictionaryForKey:LastSessionUserDefaultKey];
+        if ([lastSession[IdentifiersKey] isKindOfClass:[NSArray class]]) {
+            _lastSession = [lastSession copy];
+        }
+        _session = [lastSession mutableCopy] ?: [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    for (id observer in self.observers) {
+        [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    }
+}
+
+- (void)start
+{
+    if (self.started) {
+        return;
+    }
+    self.started = YES;
+
+    __weak AirTurnReconnector *weakSelf = self;
+    NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+    NSOperationQueue *mainQueue = [NSOperationQueue mainQueue];
+    [self.observers addObject:[center addObserverForName:AirTurnConnectionStateChangedNotification object:nil queue:mainQueue usingBlock:^(NSNotification *note) {
+        if ([note.userInfo[AirTurnConnectionStateKey] integerValue] == AirTurnConnectionStateReady) {
+            [weakSelf peripheralDidBecomeReady:note.userInfo[AirTurnPeripheralKey]];
+        }
+    }]];
+
+    if (![self shouldReconnect]) {
+        return;
+    }
+
+    self.waitingForCentral = YES;
+    self.startedAt = AirTurnLatencyNow();
+    self.startedSinceLaunch = AirTurnMillisecondsSinceLaunch();
+
+    [self.observers addObject:[center addObserverForName:AirTurnCentralStateChangedNotification object:nil queue:mainQueue usingBlock:^(NSNotification *note) {
+        [weakSelf connectLastSession];
+    }]];
+
+    [AirTurnCentral sharedCentral].enabled = YES;
+    [self connectLastSession];
+}
+
+- (BOOL)shouldReconnect
+{
+    if ([self.lastSession[IdentifiersKey] count] == 0) {
+        return NO;
+    }
+
+    NSNumber *restore = [[NSBundle mainBundle] objectForInfoDictionaryKey:RestoreStateInfoKey];
+    if (restore != nil && !restore.boolValue) {
+        return NO;
+    }
+
+    NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+    return [defaults boolForKey:EnabledUserDefaultKey] && [defaults boolForKey:AirDirectModeUserDefaultKey];
+}
+
+- (void)connectLastSession
+{
+    if (!self.waitingForCentral) {
+        return;
+    }
+
+    AirTurnCentral *central = [AirTurnCentral sharedCentral];
+    if (central.state != AirTurnCentralStateDisconnected && central.state != AirTurnCentralStateConnected) {
+        // not usable yet, the next central state change tries again
+        return;
+    }
+    self.waitingForCentral = NO;
+
+    NSArray<NSString *> *identifiers = self.lastSession[IdentifiersKey];
+    NSString *lastIdentifier = self.lastSession[LastIdentifierKey];
+
+    NSMutableArray<AirTurnPeripheral *> *peripherals = [NSMutableArray array];
+    for (AirTurnPeripheral *peripheral in central.storedAirTurns) {
+        if (peripheral.state != AirTurnConnectionStateDisconnected || ![identifiers containsObject:peripheral.identifier]) {
+            continue;
+        }
+        if ([peripheral.identifier isEqualToString:lastIdentifier]) {
+            [peripherals insertObject:peripheral atIndex:0];
+        } else {
+            [peripherals addObject:peripheral];
+        }
+    }
+
+    for (AirTurnPeripheral *peripheral in peripherals) {
+        [central connectToAirTurn:peripheral];
+    }
+    self.attempted = peripherals.count;
+}
+
+- (void)peripheralDidBecomeReady:(AirTurnPeripheral *)peripheral
+{
+    if (!peripheral.identifier) {
+        return;
+    }
+
+    if (self.startedAt && !self.timeToReady) {
+        self.timeToReady = AirTurnLatencyNow() - self.startedAt;
+        self.readySinceLaunch = AirTurnMillisecondsSinceLaunch();
+    }
+
+    AirTurnPeripheralConnectionConfiguration configuration = peripheral.connectionConfiguration;
+    if (self.startedAt && !self.restoredConfiguration && [peripheral.identifier isEqualToString:self.lastSession[LastIdentifierKey]]) {
+        // once per launch, so a configuration changed since is kept
+        self.restoredConfiguration = YES;
+        NSNumber *lastConfiguration = self.lastSession[ConnectionConfigurationKey];
+        if (lastConfiguration && lastConfiguration.unsignedCharValue != configuration && (peripheral.featuresAvailable & AirTurnPeripheralFeaturesAvailableConnectionSpeedConfiguration)) {
+            configuration = lastConfiguration.unsignedCharValue;
+            [peripheral writeConnectionConfiguration:configuration];
+        }
+    }
+
+    NSMutableArray<NSString *> *identifiers = [NSMutableArray arrayWithObject:peripheral.identifier];
+    for (AirTurnPeripheral *stored in [AirTurnCentral sharedCentral].storedAirTurns) {
+        if (stored.identifier && ![identifiers containsObject:stored.identifier]) {
+            [identifiers addObject:stored.identifier];
+        }
+    }
+
+    self.session[IdentifiersKey] = identifiers;
+    self.session[LastIdentifierKey] = peripheral.identifier;
+    self.session[ConnectionConfigurationKey] = @(configuration);
+    [self persist];
+}
+
+- (void)persist
+{
+    NSDictionary *session = [self.session copy];
+
+    // off the main queue, a reconnect shouldn't wait on a defaults write
+    dispatch_async(self.persistQueue, ^{
+        [[NSUserDefaults standardUserDefaults] setObject:session forKey:LastSessionUserDefaultKey];
+    });
+}
+
+- (NSDictionary *)dictionaryRepresentation
+{
+    NSMutableDictionary *result = [NSMutableDictionary dictionaryWithCapacity:5];
+
+    result[@"lastSession"] = self.lastSession ?: [NSNull null];
+    result[@"attempted"] = @(self.attempted);
+    if (self.startedAt && self.startedSinceLaunch >= 0) {
+        result[@"startedSinceLaunch"] = @(self.startedSinceLaunch);
+    }
+    if (self.timeToReady) {
+        result[@"timeToReady"] = @((double)self.timeToReady / NSEC_PER_MSEC);
+        if (self.readySinceLaunch >= 0) {
+            result[@"readySinceLaunch"] = @(self.readySinceLaunch);
+        }
+    }
+
+    return result;
+}
+
+@end
@@ -0,0 +1,48 @@
+//
+//  AirTurnRepeatCoalescer.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+#import "AirTurnEventQueue.h"
+
+/**
+ The event name of folded key repeats
+ */
+FOUNDATION_EXTERN NSString * _Nonnull const AirTurnPedalRepeatEvent;
+
+/**
+ Folds key-repeat pedal presses into one event per port per window.
+
+ Presses with an `AirTurnPedalRepeatCount` above 0 that arrive within one window are sent as a single `AirTurnPedalRepeat` event:
+
+     {"AirTurnPortNumberKey":<port>,"AirTurnPedalRepeatCount":<latest count>,"repeats":<presses folded>,"elapsed":<ms since the initial press>}
+
+ The initial press of a hold is not folded. Must be used on the event queue's queue.
+ */
+@interface AirTurnRepeatCoalescer : NSObject
+
+- (nonnull instancetype)initWithEventQueue:(nonnull AirTurnEventQueue *)eventQueue;
+
+/**
+ How long repeats are collected before they are sent, in seconds. 0, the default, turns folding off.
+ */
+@property(nonatomic, assign) NSTimeInterval window;
+
+/**
+ Offer a pedal press to the coalescer
+
+ @param userInfo The `AirTurnPedalPressNotification` user info
+ @param receivedAt When the press was received, from `AirTurnLatencyNow()`
+ @return YES if the press was folded and must not be sent on its own
+ */
+- (BOOL)foldPress:(nullable NSDictionary *)userInfo receivedAt:(uint64_t)receivedAt;
+
+/**
+ Send any folded repeats now
+ */
+- (void)flush;
+
+- (void)reset;
+
+@end
@@ -0,0 +1,128 @@
+//
+//  AirTurnRepeatCoalescer.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnRepeatCoalescer.h"
+#import "AirTurnLatencyStats.h"
+#import <AirTurnInterface/AirTurnInterface.h>
+
+NSString * const AirTurnPedalRepeatEvent = @"AirTurnPedalRepeat";
+
+typedef struct {
+    uint64_t pressedAt;
+    uint64_t lastRepeatAt;
+    NSInteger repeatCount;
+    NSUInteger folded;
+} AirTurnRepeatPort;
+
+@interface AirTurnRepeatCoalescer() {
+    AirTurnRepeatPort _ports[AirTurnPortMaximum + 1];
+}
+
+@property(nonatomic, strong) AirTurnEventQueue *eventQueue;
+@property(nonatomic, strong) AirTurnEventEncoder *encoder;
+@property(nonatomic, assign) NSUInteger flushGeneration;
+@property(nonatomic, assign) BOOL flushScheduled;
+
+@end
+
+@implementation AirTurnRepeatCoalescer
+
+- (instancetype)initWithEventQueue:(AirTurnEventQueue *)eventQueue
+{
+    self = [super init];
+    if (self) {
+        _eventQueue = eventQueue;
+        _encoder = [AirTurnEventEncoder encoderForEventName:AirTurnPedalRepeatEvent];
+    }
+    return self;
+}
+
+- (void)setWindow:(NSTimeInterval)window
+{
+    // repeats collected under the old window go out now
+    [self flush];
+    _window = MAX(0, window);
+}
+
+- (BOOL)foldPress:(NSDictionary *)userInfo receivedAt:(uint64_t)receivedAt
+{
+    AirTurnPort port = [userInfo[AirTurnPortNumberKey] integerValue];
+    if (port < AirTurnPortMinimum || port > AirTurnPortMaximum) {
+        return NO;
+    }
+
+    AirTurnRepeatPort *p = &_ports[port];
+    NSInteger repeatCount = [userInfo[AirTurnPedalRepeatCount] integerValue];
+
+    if (repeatCount <= 0) {
+        // a new hold starts here, anything still folded belongs to the previous one
+        if (p->folded) {
+            [self flush];
+        }
+        p->pressedAt = receivedAt;
+        return NO;
+    }
+
+    if (self.window <= 0) {
+        return NO;
+    }
+
+    p->repeatCount = repeatCount;
+    p->lastRepeatAt = receivedAt;
+    p->folded++;
+
+    if (!self.flushScheduled) {
+        self.flushScheduled = YES;
+        NSUInteger generation = self.flushGeneration;
+        __typeof(self) __weak weakSelf = self;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.window * NSEC_PER_SEC)), self.eventQueue.queue, ^{
+            __typeof(self) __strong strongSelf = weakSelf;
+            if (strongSelf.flushGeneration == generation) {
+                [strongSelf flush];
+            }
+        });
+    }
+    return YES;
+}
+
+- (void)flush
+{
+    self.flushGeneration++;
+    self.flushScheduled = NO;
+
+    for (AirTurnPort port = AirTurnPortMinimum; port <= AirTurnPortMaximum; port++) {
+        AirTurnRepeatPort *p = &_ports[port];
+        if (!p->folded) {
+            continue;
+        }
+
+        NSInteger repeatCount = p->repeatCount;
+        NSUInteger folded = p->folded;
+        // a hold that started before the coalescer saw it has no initial press time
+        uint64_t elapsedMs = p->pressedAt && p->lastRepeatAt > p->pressedAt ? (p->lastRepeatAt - p->pressedAt) / NSEC_PER_MSEC : 0;
+        p->folded = 0;
+
+        [self.eventQueue enqueueEvent:self.encoder payload:^(AirTurnEventBuffer *buffer) {
+            AirTurnEventBufferAppendLiteral(buffer, "{\"AirTurnPortNumberKey\":");
+            AirTurnEventBufferAppendInteger(buffer, port);
+            AirTurnEventBufferAppendLiteral(buffer, ",\"AirTurnPedalRepeatCount\":");
+            AirTurnEventBufferAppendInteger(buffer, repeatCount);
+            AirTurnEventBufferAppendLiteral(buffer, ",\"repeats\":");
+            AirTurnEventBufferAppendInteger(buffer, (long long)folded);
+            AirTurnEventBufferAppendLiteral(buffer, ",\"elapsed\":");
+            AirTurnEventBufferAppendInteger(buffer, (long long)elapsedMs);
+            AirTurnEventBufferAppendLiteral(buffer, "}");
+        }];
+    }
+}
+
+- (void)reset
+{
+    self.flushGeneration++;
+    self.flushScheduled = NO;
+    memset(_ports, 0, sizeof(_ports));
+}
+
+@end
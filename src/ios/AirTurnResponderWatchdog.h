@@ -0,0 +1,36 @@
+//
+//  AirTurnResponderWatchdog.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Keeps `AirTurnViewManager` first responder, so pedal presses in keyboard mode keep arriving after the page moves focus around.
+
+ The watchdog checks after the keyboard state monitor reports a first responder or owner change, the keyboard hides, a window becomes key or the App becomes active, once things have been quiet for the debounce interval. If the AirTurn view is enabled but has lost first responder it takes it back. It leaves first responder alone while `textEditing` is set, and while another App in split screen owns it. Must be used on the main queue.
+ */
+@interface AirTurnResponderWatchdog : NSObject
+
+@property(nonatomic, readonly) BOOL watching;
+
+/**
+ Set while the user is typing in the page. While set nothing is reclaimed; clearing it checks again.
+ */
+@property(nonatomic, assign) BOOL textEditing;
+
+/**
+ Start watching, or change the debounce of the running watchdog
+
+ @param options `debounce`: quiet time before checking, in milliseconds, default 250
+ */
+- (void)startWithOptions:(nullable NSDictionary *)options;
+
+- (void)stop;
+
+/**
+ Counters since the watchdog was created: `lost` (checks that found first responder elsewhere), `reclaims` (first responder taken back), `failed` (taking it back was refused) and `skipped` (checks while text editing or owned by another App), plus `watching` and `textEditing`
+ */
+- (nonnull NSDictionary *)statistics;
+
+@end
@@ -0,0 +1,150 @@
+//
+//  AirTurnResponderWatchdog.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnResponderWatchdog.h"
+#import <UIKit/UIKit.h>
+#import <AirTurnInterface/AirTurnInterface.h>
+
+static const NSTimeInterval DefaultDebounceInterval = 0.25;
+
+@interface AirTurnResponderWatchdog()
+
+@property(nonatomic, assign) BOOL watching;
+@property(nonatomic, assign) NSTimeInterval debounceInterval;
+@property(nonatomic, strong) NSMutableArray *observers;
+@property(nonatomic, assign) NSUInteger checkGeneration;
+
+@property(nonatomic, assign) NSUInteger lost;
+@property(nonatomic, assign) NSUInteger reclaims;
+@property(nonatomic, assign) NSUInteger failed;
+@property(nonatomic, assign) NSUInteger skipped;
+
+@end
+
+@implementation AirTurnResponderWatchdog
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _debounceInterval = DefaultDebounceInterval;
+        _observers = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    for (id observer in _observers) {
+        [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    }
+}
+
+- (void)startWithOptions:(NSDictionary *)options
+{
+    NSNumber *debounce = options[@"debounce"];
+    self.debounceInterval = [debounce isKindOfClass:[NSNumber class]] ? MAX(0, [debounce doubleValue]) / 1000.0 : DefaultDebounceInterval;
+
+    if (!self.watching) {
+        self.watching = YES;
+
+        __weak AirTurnResponderWatchdog *weakSelf = self;
+        NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+        for (NSString *name in @[AirTurnKeyboardStateMonitorFirstResponderChangedNotification,
+                                 AirTurnKeyboardStateMonitorFirstResponderOwnerChangedNotification,
+                                 UIKeyboardDidHideNotification,
+                                 UIWindowDidBecomeKeyNotification,
+                                 UIApplicationDidBecomeActiveNotification]) {
+            [self.observers addObject:[center addObserverForName:name object:nil queue:[NSOperationQueue mainQueue] usingBlock:^(NSNotification *note) {
+                [weakSelf scheduleCheck];
+            }]];
+        }
+    }
+
+    [self scheduleCheck];
+}
+
+- (void)stop
+{
+    if (!self.watching) {
+        return;
+    }
+    self.watching = NO;
+    self.checkGeneration++;
+
+    for (id observer in self.observers) {
+        [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    }
+    [self.observers removeAllObjects];
+}
+
+- (void)setTextEditing:(BOOL)textEditing
+{
+    if (_textEditing == textEditing) {
+        return;
+    }
+    _textEditing = textEditing;
+
+    if (!textEditing) {
+        [self scheduleCheck];
+    }
+}
+
+- (void)scheduleCheck
+{
+    if (!self.watching) {
+        return;
+    }
+
+    // a burst of focus changes ends in one check
+    NSUInteger generation = ++self.checkGeneration;
+    __weak AirTurnResponderWatchdog *weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.debounceInterval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        AirTurnResponderWatchdog *strongSelf = weakSelf;
+        if (strongSelf.checkGeneration == generation) {
+            [strongSelf check];
+        }
+    });
+}
+
+- (void)check
+{
+    // don't bring the view manager up just to check it
+    if (![AirTurnViewManager initialized]) {
+        return;
+    }
+    AirTurnViewManager *viewManager = [AirTurnViewManager sharedViewManager];
+    if (!viewManager.enabled || [viewManager isFirstResponder]) {
+        return;
+    }
+
+    self.lost++;
+
+    BOOL remote = [AirTurnKeyboardStateMonitor initialized] && [AirTurnKeyboardStateMonitor sharedMonitor].firstResponderOwner == AirTurnFirstResponderOwnerRemote;
+    if (self.textEditing || remote) {
+        self.skipped++;
+        return;
+    }
+
+    if ([viewManager becomeFirstResponder]) {
+        self.reclaims++;
+    } else {
+        self.failed++;
+    }
+}
+
+- (NSDictionary *)statistics
+{
+    return @{
+             @"watching": @(self.watching),
+             @"textEditing": @(self.textEditing),
+             @"lost": @(self.lost),
+             @"reclaims": @(self.reclaims),
+             @"failed": @(self.failed),
+             @"skipped": @(self.skipped)
+             };
+}
+
+@end
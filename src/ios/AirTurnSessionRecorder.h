@@ -0,0 +1,86 @@
+//
+//  AirTurnSessionRecorder.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Session files start with this header, followed by records
+ */
+typedef struct __attribute__((packed)) {
+    char magic[4];          // "ATSR"
+    uint16_t version;       // AirTurnSessionVersion
+    uint16_t recordSize;    // sizeof(AirTurnSessionRecord)
+    uint64_t startedAt;     // Unix time in microseconds
+} AirTurnSessionHeader;
+
+typedef NS_ENUM(uint8_t, AirTurnSessionRecordType) {
+    /**
+     Introduces a peripheral index. `value` is the byte length of its UTF-8 identifier, which follows in as many whole records as it needs.
+     */
+    AirTurnSessionRecordTypePeripheral = 0,
+    AirTurnSessionRecordTypeConnectionState, // value: AirTurnConnectionState
+    AirTurnSessionRecordTypePedalDown,
+    AirTurnSessionRecordTypePedalUp,
+    AirTurnSessionRecordTypePedalPress,      // value: AirTurnPedalRepeatCount
+    AirTurnSessionRecordTypeAnalogValue,     // value: analog port value
+    AirTurnSessionRecordTypeBatteryLevel,    // value: battery level
+    AirTurnSessionRecordTypeChargingState    // value: AirTurnPeripheralChargingState
+};
+
+/**
+ One recorded notification, little endian
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t delta;         // microseconds since the previous record, saturating
+    uint8_t type;           // AirTurnSessionRecordType
+    uint8_t peripheral;     // peripheral index, AirTurnSessionNoPeripheral if none
+    uint8_t port;           // AirTurnPort, 0 if none
+    uint8_t reserved;
+    int32_t value;
+} AirTurnSessionRecord;
+
+static const uint16_t AirTurnSessionVersion = 1;
+static const uint8_t AirTurnSessionNoPeripheral = 0xff;
+
+/**
+ Records every connection, pedal, analog, battery and charging notification to a compact binary file of fixed-size records, for `AirTurnSessionReplayer` to play back.
+
+ Records are buffered in memory and written behind on a utility queue, so recording adds no file I/O to the event path.
+ */
+@interface AirTurnSessionRecorder : NSObject
+
+/**
+ The directory sessions are recorded to, in the caches directory
+ */
++ (nonnull NSString *)sessionsDirectory;
+
+/**
+ @param notificationCenter The center to record from, the plugin's, so a session holds what the plugin saw
+ @param notificationQueue The operation queue notifications are observed on
+ */
+- (nonnull instancetype)initWithNotificationCenter:(nonnull NSNotificationCenter *)notificationCenter notificationQueue:(nonnull NSOperationQueue *)notificationQueue;
+
+/**
+ The file being recorded to, nil when not recording
+ */
+@property(nonatomic, copy, readonly, nullable) NSString *path;
+
+/**
+ Start recording to a new file
+
+ @param name The file name, without extension. nil names it after the current time.
+ @param error Set when the file can't be created
+ @return The path recorded to, or nil on error
+ */
+- (nullable NSString *)startWithName:(nullable NSString *)name error:(NSError * _Nullable * _Nullable)error;
+
+/**
+ Stop recording and write out what is buffered
+
+ @param completion Called on the main queue once the file is complete, with the keys `path`, `records` and `bytes`
+ */
+- (void)stopWithCompletion:(nullable void (^)(NSDictionary * _Nonnull result))completion;
+
+@end
@@ -0,0 +1,249 @@
+//
+//  AirTurnSessionRecorder.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnSessionRecorder.h"
+#import "AirTurnEventEncoder.h"
+#import "AirTurnLatencyStats.h"
+#import <AirTurnInterface/AirTurnInterface.h>
+
+static const size_t WriteThreshold = 4096;
+
+@interface AirTurnSessionRecorder() {
+    // confined to the notification queue while recording
+    AirTurnEventBuffer _buffer;
+}
+
+@property(nonatomic, strong) NSNotificationCenter *notificationCenter;
+@property(nonatomic, strong) NSOperationQueue *notificationQueue;
+@property(nonatomic, strong) dispatch_queue_t ioQueue;
+@property(atomic, strong) NSFileHandle *fileHandle;
+@property(nonatomic, copy, readwrite) NSString *path;
+@property(nonatomic, strong) NSArray *observers;
+
+@property(nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *peripheralIndexes;
+@property(nonatomic, assign) uint64_t lastRecordAt;
+@property(nonatomic, assign) NSUInteger records;
+@property(nonatomic, assign) unsigned long long bytes;
+
+@end
+
+@implementation AirTurnSessionRecorder
+
++ (NSString *)sessionsDirectory
+{
+    NSString *caches = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES).firstObject;
+    return [caches stringByAppendingPathComponent:@"AirTurnSessions"];
+}
+
+- (instancetype)initWithNotificationCenter:(NSNotificationCenter *)notificationCenter notificationQueue:(NSOperationQueue *)notificationQueue
+{
+    self = [super init];
+    if (self) {
+        _notificationCenter = notificationCenter;
+        _notificationQueue = notificationQueue;
+        _ioQueue = dispatch_queue_create("com.airturn.cordova.sessionrecorder", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+        AirTurnEventBufferInit(&_buffer, WriteThreshold * 2);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    for (id observer in _observers) {
+        [_notificationCenter removeObserver:observer];
+    }
+    [_fileHandle closeFile];
+    AirTurnEventBufferFree(&_buffer);
+}
+
+- (NSString *)startWithName:(NSString *)name error:(NSError **)error
+{
+    if (self.observers) {
+        return self.path;
+    }
+
+    NSString *directory = [AirTurnSessionRecorder sessionsDirectory];
+    if (![[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:error]) {
+        return nil;
+    }
+
+    if (name.length == 0) {
+        NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+        formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+        formatter.dateFormat = @"yyyyMMdd-HHmmss";
+        name = [formatter stringFromDate:[NSDate date]];
+    }
+    NSString *path = [directory stringByAppendingPathComponent:[[name lastPathComponent] stringByAppendingPathExtension:@"atsr"]];
+
+    AirTurnSessionHeader header = { .magic = { 'A', 'T', 'S', 'R' }, .version = AirTurnSessionVersion, .recordSize = sizeof(AirTurnSessionRecord) };
+    header.startedAt = (uint64_t)([[NSDate date] timeIntervalSince1970] * USEC_PER_SEC);
+    NSData *headerData = [NSData dataWithBytes:&header length:sizeof(header)];
+    if (![headerData writeToFile:path options:NSDataWritingAtomic error:error]) {
+        return nil;
+    }
+
+    self.fileHandle = [NSFileHandle fileHandleForWritingAtPath:path];
+    [self.fileHandle seekToEndOfFile];
+    self.path = path;
+
+    [self.notificationQueue addOperationWithBlock:^{
+        self->_buffer.length = 0;
+        self.peripheralIndexes = [NSMutableDictionary dictionary];
+        self.lastRecordAt = AirTurnLatencyNow();
+        self.records = 0;
+        self.bytes = sizeof(header);
+    }];
+
+    __typeof(self) __weak weakSelf = self;
+    NSNotificationCenter *nc = self.notificationCenter;
+    NSDictionary<NSString *, NSNumber *> *types = @{
+        AirTurnConnectionStateChangedNotification: @(AirTurnSessionRecordTypeConnectionState),
+        AirTurnPedalDownNotification: @(AirTurnSessionRecordTypePedalDown),
+        AirTurnPedalUpNotification: @(AirTurnSessionRecordTypePedalUp),
+        AirTurnPedalPressNotification: @(AirTurnSessionRecordTypePedalPress),
+        AirTurnAnalogPortValueChangeNotification: @(AirTurnSessionRecordTypeAnalogValue),
+        AirTurnDidUpdateBatteryLevelNotification: @(AirTurnSessionRecordTypeBatteryLevel),
+        AirTurnDidUpdateChargingStateNotification: @(AirTurnSessionRecordTypeChargingState)
+    };
+    NSMutableArray *observers = [NSMutableArray arrayWithCapacity:types.count];
+    [types enumerateKeysAndObjectsUsingBlock:^(NSString *notificationName, NSNumber *type, BOOL *stop) {
+        AirTurnSessionRecordType recordType = (AirTurnSessionRecordType)[type unsignedCharValue];
+        [observers addObject:[nc addObserverForName:notificationName object:nil queue:self.notificationQueue usingBlock:^(NSNotification *note) {
+            [weakSelf recordType:recordType userInfo:note.userInfo];
+        }]];
+    }];
+    self.observers = observers;
+
+    return path;
+}
+
+- (void)stopWithCompletion:(void (^)(NSDictionary *))completion
+{
+    for (id observer in self.observers) {
+        [self.notificationCenter removeObserver:observer];
+    }
+    self.observers = nil;
+
+    NSString *path = self.path;
+    self.path = nil;
+
+    // observer blocks already queued still record, then the rest of the buffer goes out
+    [self.notificationQueue addOperationWithBlock:^{
+        [self writeBuffer];
+        NSDictionary *result = @{ @"path": path ?: @"", @"records": @(self.records), @"bytes": @(self.bytes) };
+        NSFileHandle *fileHandle = self.fileHandle;
+        self.fileHandle = nil;
+
+        dispatch_async(self.ioQueue, ^{
+            [fileHandle synchronizeFile];
+            [fileHandle closeFile];
+            if (completion) {
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    completion(result);
+                });
+            }
+        });
+    }];
+}
+
+#pragma mark - Notification queue
+
+- (void)appendRecord:(AirTurnSessionRecord)record
+{
+    AirTurnEventBufferAppend(&_buffer, (const char *)&record, sizeof(record));
+    self.records++;
+}
+
+- (uint8_t)indexForPeripheral:(AirTurnPeripheral *)p
+{
+    if (!p.identifier) {
+        return AirTurnSessionNoPeripheral;
+    }
+
+    NSNumber *index = self.peripheralIndexes[p.identifier];
+    if (index) {
+        return [index unsignedCharValue];
+    }
+    if (self.peripheralIndexes.count >= AirTurnSessionNoPeripheral) {
+        return AirTurnSessionNoPeripheral;
+    }
+
+    uint8_t newIndex = (uint8_t)self.peripheralIndexes.count;
+    self.peripheralIndexes[p.identifier] = @(newIndex);
+
+    const char *utf8 = p.identifier.UTF8String;
+    size_t length = strlen(utf8);
+    [self appendRecord:(AirTurnSessionRecord){ .type = AirTurnSessionRecordTypePeripheral, .peripheral = newIndex, .value = (int32_t)length }];
+
+    // the identifier follows, zero padded to whole records
+    size_t padded = (length + sizeof(AirTurnSessionRecord) - 1) / sizeof(AirTurnSessionRecord) * sizeof(AirTurnSessionRecord);
+    char zeros[sizeof(AirTurnSessionRecord)] = { 0 };
+    AirTurnEventBufferAppend(&_buffer, utf8, length);
+    AirTurnEventBufferAppend(&_buffer, zeros, padded - length);
+
+    return newIndex;
+}
+
+- (void)recordType:(AirTurnSessionRecordType)type userInfo:(NSDictionary *)userInfo
+{
+    if (!self.fileHandle) {
+        return;
+    }
+
+    AirTurnPeripheral *p = userInfo[AirTurnPeripheralKey];
+    AirTurnPort port = [userInfo[AirTurnPortNumberKey] integerValue];
+    int32_t value = 0;
+
+    switch (type) {
+        case AirTurnSessionRecordTypeConnectionState: value = [userInfo[AirTurnConnectionStateKey] intValue]; port = 0; break;
+        case AirTurnSessionRecordTypePedalPress: value = [userInfo[AirTurnPedalRepeatCount] intValue]; break;
+        case AirTurnSessionRecordTypeAnalogValue: value = p ? [p analogPortValue:port] : 0; break;
+        case AirTurnSessionRecordTypeBatteryLevel: value = (int32_t)p.batteryLevel; port = 0; break;
+        case AirTurnSessionRecordTypeChargingState: value = (int32_t)p.chargingState; port = 0; break;
+        default: break;
+    }
+
+    // a peripheral record must precede its first use, with no time of its own
+    uint8_t peripheral = p ? [self indexForPeripheral:p] : AirTurnSessionNoPeripheral;
+
+    uint64_t now = AirTurnLatencyNow();
+    uint64_t delta = (now - self.lastRecordAt) / NSEC_PER_USEC;
+    self.lastRecordAt = now;
+
+    [self appendRecord:(AirTurnSessionRecord){
+        .delta = (uint32_t)MIN(delta, UINT32_MAX),
+        .type = type,
+        .peripheral = peripheral,
+        .port = (uint8_t)MAX(0, MIN(port, UINT8_MAX)),
+        .value = value
+    }];
+
+    if (_buffer.length >= WriteThreshold) {
+        [self writeBuffer];
+    }
+}
+
+- (void)writeBuffer
+{
+    if (_buffer.length == 0 || !self.fileHandle) {
+        return;
+    }
+
+    NSData *data = [NSData dataWithBytes:_buffer.bytes length:_buffer.length];
+    self.bytes += _buffer.length;
+    _buffer.length = 0;
+
+    NSFileHandle *fileHandle = self.fileHandle;
+    dispatch_async(self.ioQueue, ^{
+        @try {
+            [fileHandle writeData:data];
+        }
+        @catch (NSException *exception) {
+            NSLog(@"AirTurnSessionRecorder: write failed: %@", exception.reason);
+        }
+    });
+}
+
+@end
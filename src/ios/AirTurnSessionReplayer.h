@@ -0,0 +1,42 @@
+//
+//  AirTurnSessionReplayer.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Plays a session recorded by `AirTurnSessionRecorder` back as notifications.
+
+ Replayed notifications carry the peripheral identifier and value under `AirTurnEventPeripheralIdentifierKey` and `AirTurnEventValueKey` instead of an `AirTurnPeripheral`, which the encoders and analog streamer understand.
+ */
+@interface AirTurnSessionReplayer : NSObject
+
+/**
+ Load a session file
+
+ @param path The file
+ @param error Set if the file can't be read or isn't a session
+ @return The replayer, or nil on error
+ */
+- (nullable instancetype)initWithContentsOfFile:(nonnull NSString *)path error:(NSError * _Nullable * _Nullable)error;
+
+/**
+ The notifications in the session, in order
+ */
+@property(nonatomic, readonly, nonnull) NSArray<NSNotification *> *notifications;
+
+/**
+ The recorded duration in seconds
+ */
+@property(nonatomic, readonly) NSTimeInterval duration;
+
+/**
+ Post every notification on a center with the recorded spacing. Blocks until done, so must not be called on the main thread.
+
+ @param center The notification center to post on
+ @param speed How many times faster than recorded to play, 0 for as fast as possible
+ */
+- (void)replayToCenter:(nonnull NSNotificationCenter *)center speed:(double)speed;
+
+@end
@@ -0,0 +1,166 @@
+//
+//  AirTurnSessionReplayer.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnSessionReplayer.h"
+#import "AirTurnSessionRecorder.h"
+#import "AirTurnEventEncoder.h"
+#import "AirTurnLatencyStats.h"
+#import <AirTurnInterface/AirTurnInterface.h>
+
+static NSString * const ErrorDomain = @"AirTurnSessionReplayer";
+
+@interface AirTurnSessionReplayer() {
+    // microseconds from the start of the session, one per notification
+    uint64_t *_offsets;
+}
+
+@property(nonatomic, strong, readwrite) NSArray<NSNotification *> *notifications;
+@property(nonatomic, assign, readwrite) NSTimeInterval duration;
+
+@end
+
+@implementation AirTurnSessionReplayer
+
+static NSNotification *NotificationForRecord(const AirTurnSessionRecord *record, NSString *identifier)
+{
+    NSString *name;
+    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:4];
+
+    switch (record->type) {
+        case AirTurnSessionRecordTypeConnectionState:
+            name = AirTurnConnectionStateChangedNotification;
+            userInfo[AirTurnConnectionStateKey] = @(record->value);
+            break;
+        case AirTurnSessionRecordTypePedalDown:
+            name = AirTurnPedalDownNotification;
+            userInfo[AirTurnPortStateKey] = @(AirTurnPortStateDown);
+            break;
+        case AirTurnSessionRecordTypePedalUp:
+            name = AirTurnPedalUpNotification;
+            userInfo[AirTurnPortStateKey] = @(AirTurnPortStateUp);
+            break;
+        case AirTurnSessionRecordTypePedalPress:
+            name = AirTurnPedalPressNotification;
+            userInfo[AirTurnPortStateKey] = @(AirTurnPortStateDown);
+            userInfo[AirTurnPedalRepeatCount] = @(record->value);
+            break;
+        case AirTurnSessionRecordTypeAnalogValue:
+            name = AirTurnAnalogPortValueChangeNotification;
+            userInfo[AirTurnEventValueKey] = @(record->value);
+            break;
+        case AirTurnSessionRecordTypeBatteryLevel:
+            name = AirTurnDidUpdateBatteryLevelNotification;
+            userInfo[AirTurnEventValueKey] = @(record->value);
+            break;
+        case AirTurnSessionRecordTypeChargingState:
+            name = AirTurnDidUpdateChargingStateNotification;
+            userInfo[AirTurnEventValueKey] = @(record->value);
+            break;
+        default:
+            // a newer record type, skip it
+            return nil;
+    }
+
+    if (record->port) {
+        userInfo[AirTurnPortNumberKey] = @(record->port);
+    }
+    if (identifier) {
+        userInfo[AirTurnEventPeripheralIdentifierKey] = identifier;
+    }
+    return [NSNotification notificationWithName:name object:nil userInfo:userInfo];
+}
+
+- (instancetype)initWithContentsOfFile:(NSString *)path error:(NSError **)error
+{
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:error];
+    if (!data) {
+        return nil;
+    }
+
+    AirTurnSessionHeader header = { { 0 } };
+    if (data.length >= sizeof(header)) {
+        memcpy(&header, data.bytes, sizeof(header));
+    }
+    if (memcmp(header.magic, "ATSR", 4) != 0 || header.version > AirTurnSessionVersion || header.recordSize < sizeof(AirTurnSessionRecord)) {
+        if (error) {
+            *error = [NSError errorWithDomain:ErrorDomain code:1 userInfo:@{ NSLocalizedDescriptionKey: @"Not an AirTurn session file" }];
+        }
+        return nil;
+    }
+
+    const uint8_t *bytes = data.bytes;
+    size_t recordSize = header.recordSize;
+    size_t offset = sizeof(header);
+    size_t capacity = (data.length - offset) / recordSize;
+
+    NSMutableArray<NSNotification *> *notifications = [NSMutableArray arrayWithCapacity:capacity];
+    NSMutableDictionary<NSNumber *, NSString *> *identifiers = [NSMutableDictionary dictionary];
+    _offsets = malloc(MAX(capacity, 1) * sizeof(uint64_t));
+    uint64_t elapsed = 0;
+
+    while (offset + recordSize <= data.length) {
+        AirTurnSessionRecord record;
+        memcpy(&record, bytes + offset, sizeof(record));
+        offset += recordSize;
+        elapsed += record.delta;
+
+        if (record.type == AirTurnSessionRecordTypePeripheral) {
+            size_t length = (size_t)MAX(0, record.value);
+            size_t padded = (length + recordSize - 1) / recordSize * recordSize;
+            if (offset + padded > data.length) {
+                break;
+            }
+            NSString *identifier = [[NSString alloc] initWithBytes:bytes + offset length:length encoding:NSUTF8StringEncoding];
+            if (identifier) {
+                identifiers[@(record.peripheral)] = identifier;
+            }
+            offset += padded;
+            continue;
+        }
+
+        NSNotification *note = NotificationForRecord(&record, identifiers[@(record.peripheral)]);
+        if (note) {
+            _offsets[notifications.count] = elapsed;
+            [notifications addObject:note];
+        }
+    }
+
+    _notifications = notifications;
+    _duration = (double)elapsed / USEC_PER_SEC;
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_offsets);
+}
+
+- (void)replayToCenter:(NSNotificationCenter *)center speed:(double)speed
+{
+    NSAssert(![NSThread isMainThread], @"AirTurnSessionReplayer must not replay on the main thread");
+
+    uint64_t start = AirTurnLatencyNow();
+
+    for (NSUInteger i = 0; i < self.notifications.count; i++) {
+        if (speed > 0) {
+            // schedule against the start, not the previous post, so delays don't accumulate
+            uint64_t due = start + (uint64_t)(_offsets[i] * NSEC_PER_USEC / speed);
+            uint64_t now = AirTurnLatencyNow();
+            if (due > now) {
+                usleep((useconds_t)MIN((due - now) / NSEC_PER_USEC, (uint64_t)UINT32_MAX));
+            }
+        }
+        @autoreleasepool {
+            [center postNotification:self.notifications[i]];
+        }
+    }
+}
+
+@end
@@ -0,0 +1,30 @@
+//
+//  AirTurnSnapshotStore.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Builds versioned snapshots of every connected, connecting and discovered AirTurn so pollers only receive what changed.
+
+ Each peripheral entry carries the version at which it last changed. Versions increase monotonically for the lifetime of the store. Must be used on the main queue.
+ */
+@interface AirTurnSnapshotStore : NSObject
+
+/**
+ The version of the most recent change seen
+ */
+@property(nonatomic, readonly) unsigned long long version;
+
+/**
+ Snapshot the peripherals and return the entries that changed after a version.
+
+ The result has the keys `version` (the current version, pass it back next time), `centralState`, `peripherals` (changed entries), `removed` (identifiers of peripherals gone since `sinceVersion`) and `full`. Only the most recent 64 removals are remembered; when `sinceVersion` is older than a forgotten one, or 0, `full` is true and `peripherals` holds every entry, to replace rather than merge into what the caller has. Each entry has the keys `identifier`, `name`, `connectionState`, `batteryLevel`, `chargingState`, `mode`, `ports` (digital port states for ports 1-8, -1 where unavailable) and `version`.
+
+ @param sinceVersion The version the caller last saw, 0 for everything
+ @return The snapshot delta
+ */
+- (nonnull NSDictionary *)snapshotSinceVersion:(unsigned long long)sinceVersion;
+
+@end
@@ -0,0 +1,133 @@
+//
+//  AirTurnSnapshotStore.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnSnapshotStore.h"
+#import <AirTurnInterface/AirTurnInterface.h>
+
+static NSString * const VersionKey = @"version";
+// removals remembered for callers that are behind; older ones are forgotten
+static const NSUInteger MaximumRemoved = 64;
+
+@interface AirTurnSnapshotStore()
+
+@property(nonatomic, assign) unsigned long long version;
+@property(nonatomic, strong) NSMutableDictionary<NSString *, NSDictionary *> *entries;
+@property(nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *removed;
+// the newest version of a removal no longer remembered; callers older than it get everything
+@property(nonatomic, assign) unsigned long long removedHorizon;
+
+@end
+
+@implementation AirTurnSnapshotStore
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _entries = [NSMutableDictionary dictionary];
+        _removed = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
++ (NSDictionary *)entryForPeripheral:(AirTurnPeripheral *)p
+{
+    NSMutableArray *ports = [NSMutableArray arrayWithCapacity:AirTurnPortMaximum];
+    for (AirTurnPort port = AirTurnPortMinimum; port <= AirTurnPortMaximum; port++) {
+        [ports addObject:@([p digitalPortAvailable:port] ? [p digitalPortState:port] : AirTurnPortStateInvalid)];
+    }
+
+    return @{
+             @"identifier": p.identifier,
+             @"name": p.name ?: @"",
+             @"connectionState": @(p.state),
+             @"batteryLevel": @(p.batteryLevel),
+             @"chargingState": @(p.chargingState),
+             @"mode": @(p.currentMode),
+             @"ports": ports
+             };
+}
+
+- (NSDictionary *)snapshotSinceVersion:(unsigned long long)sinceVersion
+{
+    NSMutableSet<AirTurnPeripheral *> *peripherals = [NSMutableSet set];
+    AirTurnCentralState centralState = AirTurnCentralStateUnknown;
+
+    // don't spin the central up just to report that nothing is there
+    if ([AirTurnCentral initialized]) {
+        AirTurnCentral *central = [AirTurnCentral sharedCentral];
+        centralState = central.state;
+        [peripherals unionSet:central.connectedAirTurns];
+        [peripherals unionSet:central.connectingAirTurns];
+        [peripherals unionSet:central.discoveredAirTurns];
+    }
+
+    NSMutableSet<NSString *> *seen = [NSMutableSet setWithCapacity:peripherals.count];
+    for (AirTurnPeripheral *p in peripherals) {
+        NSDictionary *entry = [[self class] entryForPeripheral:p];
+        NSString *identifier = entry[@"identifier"];
+        [seen addObject:identifier];
+
+        NSMutableDictionary *previous = [self.entries[identifier] mutableCopy];
+        [previous removeObjectForKey:VersionKey];
+        if (![previous isEqualToDictionary:entry]) {
+            NSMutableDictionary *versioned = [entry mutableCopy];
+            versioned[VersionKey] = @(++self.version);
+            self.entries[identifier] = versioned;
+            [self.removed removeObjectForKey:identifier];
+        }
+    }
+
+    for (NSString *identifier in self.entries.allKeys) {
+        if (![seen containsObject:identifier]) {
+            [self.entries removeObjectForKey:identifier];
+            self.removed[identifier] = @(++self.version);
+        }
+    }
+    [self pruneRemoved];
+
+    // a caller from before a forgotten removal can't be told about it, so it starts over
+    BOOL full = sinceVersion == 0 || sinceVersion < self.removedHorizon;
+    if (full) {
+        sinceVersion = 0;
+    }
+
+    NSMutableArray *changed = [NSMutableArray array];
+    [self.entries enumerateKeysAndObjectsUsingBlock:^(NSString *identifier, NSDictionary *entry, BOOL *stop) {
+        if ([entry[VersionKey] unsignedLongLongValue] > sinceVersion) {
+            [changed addObject:entry];
+        }
+    }];
+
+    NSMutableArray *removed = [NSMutableArray array];
+    [self.removed enumerateKeysAndObjectsUsingBlock:^(NSString *identifier, NSNumber *version, BOOL *stop) {
+        if ([version unsignedLongLongValue] > sinceVersion) {
+            [removed addObject:identifier];
+        }
+    }];
+
+    return @{
+             VersionKey: @(self.version),
+             @"centralState": @(centralState),
+             @"peripherals": changed,
+             @"removed": removed,
+             @"full": @(full)
+             };
+}
+
+- (void)pruneRemoved
+{
+    if (self.removed.count <= MaximumRemoved) {
+        return;
+    }
+
+    NSArray<NSString *> *oldest = [self.removed keysSortedByValueUsingSelector:@selector(compare:)];
+    for (NSUInteger i = 0; i < oldest.count - MaximumRemoved; i++) {
+        self.removedHorizon = MAX(self.removedHorizon, [self.removed[oldest[i]] unsignedLongLongValue]);
+        [self.removed removeObjectForKey:oldest[i]];
+    }
+}
+
+@end
@@ -0,0 +1,64 @@
+//
+//  AirTurnStartupProfile.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Wall clock milliseconds since the kernel started this process, or -1 if it can't be read
+ */
+FOUNDATION_EXTERN double AirTurnMillisecondsSinceLaunch(void);
+
+/**
+ The phases of plugin initialization
+ */
+typedef NS_ENUM(NSInteger, AirTurnStartupPhase) {
+    /**
+     Log levels set and loggers registered
+     */
+    AirTurnStartupPhaseLogging = 0,
+    /**
+     `AirTurnManager` created
+     */
+    AirTurnStartupPhaseManager,
+    /**
+     `initAirTurn` called to the plugin ready, including the hops between queues
+     */
+    AirTurnStartupPhaseReady,
+    /**
+     `initAirTurn` called to the first central state notification, when Bluetooth is usable or known not to be. 0 if the central state was already known when `initAirTurn` was called.
+     */
+    AirTurnStartupPhaseFirstCentralState,
+    AirTurnStartupPhaseCount
+};
+
+/**
+ Timings of one plugin initialization. Must be used on the main queue.
+ */
+@interface AirTurnStartupProfile : NSObject
+
+/**
+ The `AirTurnLatencyNow()` at which `start` was called, or 0 if it has not been
+ */
+@property(nonatomic, readonly) uint64_t startedAt;
+
+/**
+ Mark the start of initialization, and record how long after process launch that is
+ */
+- (void)start;
+
+/**
+ Record how long a phase took
+
+ @param phase The phase
+ @param nanoseconds The time the phase took
+ */
+- (void)recordPhase:(AirTurnStartupPhase)phase nanoseconds:(uint64_t)nanoseconds;
+
+/**
+ The recorded phases in milliseconds, keyed `logging`, `manager`, `ready` and `firstCentralState`, plus `sinceLaunch`, the time from process launch to `start`. Phases not yet recorded are left out.
+ */
+- (nonnull NSDictionary *)dictionaryRepresentation;
+
+@end
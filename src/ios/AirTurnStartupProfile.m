@@ -0,0 +1,72 @@
+//
+//  AirTurnStartupProfile.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnStartupProfile.h"
+#import "AirTurnLatencyStats.h"
+#include <sys/sysctl.h>
+#include <unistd.h>
+
+static NSString * const PhaseNames[AirTurnStartupPhaseCount] = {
+    @"logging",
+    @"manager",
+    @"ready",
+    @"firstCentralState"
+};
+
+double AirTurnMillisecondsSinceLaunch(void)
+{
+    struct kinfo_proc info;
+    size_t size = sizeof(info);
+    int mib[4] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid() };
+
+    if (sysctl(mib, 4, &info, &size, NULL, 0) != 0) {
+        return -1;
+    }
+
+    struct timeval started = info.kp_proc.p_starttime;
+    double launchedAt = started.tv_sec * 1000.0 + started.tv_usec / 1000.0;
+    return (CFAbsoluteTimeGetCurrent() + kCFAbsoluteTimeIntervalSince1970) * 1000.0 - launchedAt;
+}
+
+@interface AirTurnStartupProfile() {
+    uint64_t _phases[AirTurnStartupPhaseCount];
+    BOOL _recorded[AirTurnStartupPhaseCount];
+}
+
+@property(nonatomic, assign) double sinceLaunch;
+
+@end
+
+@implementation AirTurnStartupProfile
+
+- (void)start
+{
+    _startedAt = AirTurnLatencyNow();
+    self.sinceLaunch = AirTurnMillisecondsSinceLaunch();
+}
+
+- (void)recordPhase:(AirTurnStartupPhase)phase nanoseconds:(uint64_t)nanoseconds
+{
+    _phases[phase] = nanoseconds;
+    _recorded[phase] = YES;
+}
+
+- (NSDictionary *)dictionaryRepresentation
+{
+    NSMutableDictionary *profile = [NSMutableDictionary dictionaryWithCapacity:AirTurnStartupPhaseCount + 1];
+
+    if (self.startedAt && self.sinceLaunch >= 0) {
+        profile[@"sinceLaunch"] = @(self.sinceLaunch);
+    }
+    for (NSInteger phase = 0; phase < AirTurnStartupPhaseCount; phase++) {
+        if (_recorded[phase]) {
+            profile[PhaseNames[phase]] = @((double)_phases[phase] / NSEC_PER_MSEC);
+        }
+    }
+
+    return profile;
+}
+
+@end
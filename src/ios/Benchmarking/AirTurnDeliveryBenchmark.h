@@ -0,0 +1,29 @@
+//
+//  AirTurnDeliveryBenchmark.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+
+#define DELIVERY_BENCHMARK_COUNT 200 // Probes sent per path
+#define DELIVERY_BENCHMARK_INTERVAL 10 // Milliseconds between probes
+
+@class AirTurn;
+
+/**
+ Sends the same batch of pedal events to the page through each delivery path in turn: the event stream callback, `evalJs` and, where the WebView supports it, `callAsyncJavaScript`. Each probe carries its wall clock send time, and `airturn.js` measures how long each took to arrive.
+ */
+@interface AirTurnDeliveryBenchmark : NSObject
+
+/**
+ Start sending probes. Must be called on the main thread, and returns straight away.
+
+ Probes go out interleaved, one path after the other, so every path sees the same conditions. Stream callback probes and the final result are sent to `callbackId`, the final result with the keys `count`, `interval` and `paths` (the paths probed).
+
+ @param plugin The plugin whose WebView and command delegate to use
+ @param callbackId The callback of the `runBenchmark` command
+ @param options `count` probes per path and `interval` milliseconds between probes, both optional
+ */
++ (void)runWithPlugin:(nonnull AirTurn *)plugin callbackId:(nonnull NSString *)callbackId options:(nullable NSDictionary *)options;
+
+@end
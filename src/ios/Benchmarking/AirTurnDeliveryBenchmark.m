@@ -0,0 +1,90 @@
+//
+//  AirTurnDeliveryBenchmark.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnDeliveryBenchmark.h"
+#import "AirTurn.h"
+#import "AirTurnEventEncoder.h"
+#import <AirTurnInterface/AirTurnInterface.h>
+
+static NSString * const CallbackPath = @"callback";
+static NSString * const EvalJsPath = @"evalJs";
+static NSString * const CallAsyncJavaScriptPath = @"callAsyncJavaScript";
+
+static NSString * const ProbeFunctionBody = @"window.airturn._deliveryProbe(path, batch, sentAt);";
+
+@implementation AirTurnDeliveryBenchmark
+
+/**
+ * A batch the size a quick run of page turns produces.
+**/
++ (NSString *)syntheticBatch
+{
+    AirTurnEventEncoder *encoder = [AirTurnEventEncoder encoderForEventName:AirTurnPedalPressNotification];
+
+    AirTurnEventBuffer buffer;
+    AirTurnEventBufferInit(&buffer, 256);
+    for (NSUInteger i = 0; i < 8; i++) {
+        if (i == 0) {
+            AirTurnEventBufferAppendLiteral(&buffer, "[");
+        } else {
+            AirTurnEventBufferAppendLiteral(&buffer, ",");
+        }
+        [encoder encodeUserInfo:@{ AirTurnPortNumberKey: @(AirTurnPortMinimum + (i % 2)), AirTurnPortStateKey: @(AirTurnPortStateDown), AirTurnPedalRepeatCount: @0 } intoBuffer:&buffer];
+    }
+    AirTurnEventBufferAppendLiteral(&buffer, "]");
+    NSString *batch = AirTurnEventBufferCopyString(&buffer);
+    AirTurnEventBufferFree(&buffer);
+
+    return batch;
+}
+
++ (void)sendProbeWithPlugin:(AirTurn *)plugin callbackId:(NSString *)callbackId path:(NSString *)path batch:(NSString *)batch
+{
+    double sentAt = (CFAbsoluteTimeGetCurrent() + kCFAbsoluteTimeIntervalSince1970) * 1000.0;
+
+    if ([path isEqualToString:CallbackPath]) {
+        NSString *message = [NSString stringWithFormat:@"{\"sentAt\":%.3f,\"events\":%@}", sentAt, batch];
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsString:message];
+        [pluginResult setKeepCallbackAsBool:YES];
+        [plugin.commandDelegate sendPluginResult:pluginResult callbackId:callbackId];
+    } else if ([path isEqualToString:EvalJsPath]) {
+        [plugin.commandDelegate evalJs:[NSString stringWithFormat:@"window.airturn._deliveryProbe('evalJs', %@, %.3f);", batch, sentAt]];
+    } else {
+        [plugin callPageFunction:ProbeFunctionBody arguments:@{ @"path": path, @"batch": batch, @"sentAt": @(sentAt) } completionHandler:nil];
+    }
+}
+
++ (void)runWithPlugin:(AirTurn *)plugin callbackId:(NSString *)callbackId options:(NSDictionary *)options
+{
+    NSAssert([NSThread isMainThread], @"AirTurnDeliveryBenchmark must run on the main thread");
+
+    NSUInteger count = [options[@"count"] unsignedIntegerValue] ?: DELIVERY_BENCHMARK_COUNT;
+    double interval = options[@"interval"] ? MAX(0, [options[@"interval"] doubleValue]) : DELIVERY_BENCHMARK_INTERVAL;
+
+    NSMutableArray<NSString *> *paths = [NSMutableArray arrayWithObjects:CallbackPath, EvalJsPath, nil];
+    if (plugin.canCallPageFunctions) {
+        [paths addObject:CallAsyncJavaScriptPath];
+    }
+    NSString *batch = [self syntheticBatch];
+
+    NSUInteger probes = count * paths.count;
+    for (NSUInteger i = 0; i < probes; i++) {
+        NSString *path = paths[i % paths.count];
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(i * interval * NSEC_PER_MSEC)), dispatch_get_main_queue(), ^{
+            [self sendProbeWithPlugin:plugin callbackId:callbackId path:path batch:batch];
+        });
+    }
+
+    // the result goes out after the last probe has had time to arrive
+    int64_t done = (int64_t)((probes * interval + 250) * NSEC_PER_MSEC);
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, done), dispatch_get_main_queue(), ^{
+        NSLog(@"AirTurnDeliveryBenchmark: %lu probes per path over %@", (unsigned long)count, [paths componentsJoinedByString:@", "]);
+
+        CDVPluginResult* pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:@{ @"count": @(count), @"interval": @(interval), @"paths": paths }];
+        [plugin.commandDelegate sendPluginResult:pluginResult callbackId:callbackId];
+    });
+}
+
+@end
@@ -0,0 +1,23 @@
+//
+//  AirTurnEncoderBenchmark.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+
+#define ENCODER_BENCHMARK_COUNT 100000 // Synthetic notifications per run
+#define ENCODER_BENCHMARK_BATCH 16     // Events per flushed batch for the table encoder
+
+/**
+ Compares the original per-event `NSJSONSerialization` encoding against the `AirTurnEventEncoder` table on the same synthetic notifications.
+ */
+@interface AirTurnEncoderBenchmark : NSObject
+
+/**
+ Run the benchmark and log the results
+
+ @return Results with the keys `count`, `legacyNsPerEvent`, `encoderNsPerEvent` and `speedup`
+ */
++ (nonnull NSDictionary *)run;
+
+@end
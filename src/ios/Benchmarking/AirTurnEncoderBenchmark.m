@@ -0,0 +1,146 @@
+//
+//  AirTurnEncoderBenchmark.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnEncoderBenchmark.h"
+#import "AirTurnEventEncoder.h"
+#import <AirTurnInterface/AirTurnInterface.h>
+#include <mach/mach_time.h>
+
+static uint64_t NanosecondsSince(uint64_t start)
+{
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return (mach_absolute_time() - start) * timebase.numer / timebase.denom;
+}
+
+/**
+ * The encoding done by -[AirTurn fireEvent:data:receivedAt:] before the encoder table,
+ * without the NSUserDefaults side effect on connection.
+**/
+static NSString * LegacyEncode(NSString *eventName, NSDictionary *data)
+{
+    NSString *jsonDataString = @"{}";
+
+    if( data  ) {
+
+        NSError *error;
+        NSDictionary *tmpData = data;
+        if([eventName isEqualToString:@"AirTurnConnectionStateNotification"])
+        {
+            tmpData = @{
+                        @"AirTurnConnectionStateKey":[data objectForKey:@"AirTurnConnectionStateKey"]
+                        };
+        }
+        else if([eventName isEqualToString:@"AirTurnPedalPressNotification"])
+        {
+            tmpData = @{
+                        @"AirTurnPortNumberKey":[data objectForKey:@"AirTurnPortNumberKey"]
+                        };
+        }
+
+        NSData *jsonData = [NSJSONSerialization dataWithJSONObject:tmpData
+                                                           options:(NSJSONWritingOptions)0
+                                                             error:&error];
+
+        jsonDataString = [[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding];
+    }
+
+    return [NSString stringWithFormat:@"window.airturn.fireEvent('%@', %@);", eventName, jsonDataString];
+}
+
+@implementation AirTurnEncoderBenchmark
+
+/**
+ * Mostly pedal presses, with the down/up pairs and occasional connection
+ * changes a real session produces.
+**/
++ (NSArray<NSNotification *> *)syntheticNotifications
+{
+    NSMutableArray *notes = [NSMutableArray arrayWithCapacity:ENCODER_BENCHMARK_COUNT];
+    for (NSUInteger i = 0; i < ENCODER_BENCHMARK_COUNT; i++) {
+        NSNumber *port = @(AirTurnPortMinimum + (i % 4));
+        switch (i % 10) {
+            case 7:
+                [notes addObject:[NSNotification notificationWithName:AirTurnPedalDownNotification object:nil userInfo:@{ AirTurnPortNumberKey: port, AirTurnPortStateKey: @(AirTurnPortStateDown) }]];
+                break;
+            case 8:
+                [notes addObject:[NSNotification notificationWithName:AirTurnPedalUpNotification object:nil userInfo:@{ AirTurnPortNumberKey: port, AirTurnPortStateKey: @(AirTurnPortStateUp) }]];
+                break;
+            case 9:
+                [notes addObject:[NSNotification notificationWithName:@"AirTurnConnectionStateNotification" object:nil userInfo:@{ AirTurnConnectionStateKey: @(AirTurnConnectionStateReady) }]];
+                break;
+            default:
+                [notes addObject:[NSNotification notificationWithName:AirTurnPedalPressNotification object:nil userInfo:@{ AirTurnPortNumberKey: port, AirTurnPortStateKey: @(AirTurnPortStateDown), AirTurnPedalRepeatCount: @0 }]];
+                break;
+        }
+    }
+    return notes;
+}
+
++ (NSDictionary *)run
+{
+    NSArray<NSNotification *> *notes = [self syntheticNotifications];
+
+    // encoders are resolved once per listener in the plugin, so do the same here
+    NSMutableDictionary<NSString *, AirTurnEventEncoder *> *encoders = [NSMutableDictionary dictionary];
+    for (NSNotification *note in notes) {
+        if (!encoders[note.name]) {
+            encoders[note.name] = [AirTurnEventEncoder encoderForEventName:note.name];
+        }
+    }
+    NSMutableArray<AirTurnEventEncoder *> *noteEncoders = [NSMutableArray arrayWithCapacity:notes.count];
+    for (NSNotification *note in notes) {
+        [noteEncoders addObject:encoders[note.name]];
+    }
+
+    NSUInteger legacyBytes = 0;
+    uint64_t start = mach_absolute_time();
+    @autoreleasepool {
+        for (NSNotification *note in notes) {
+            legacyBytes += LegacyEncode(note.name, note.userInfo).length;
+        }
+    }
+    uint64_t legacyNs = NanosecondsSince(start);
+
+    NSUInteger encoderBytes = 0;
+    AirTurnEventBuffer buffer;
+    AirTurnEventBufferInit(&buffer, 1024);
+    start = mach_absolute_time();
+    @autoreleasepool {
+        NSUInteger i = 0;
+        for (NSNotification *note in notes) {
+            if (i % ENCODER_BENCHMARK_BATCH == 0) {
+                AirTurnEventBufferAppendLiteral(&buffer, "[");
+            } else {
+                AirTurnEventBufferAppendLiteral(&buffer, ",");
+            }
+            [noteEncoders[i] encodeUserInfo:note.userInfo intoBuffer:&buffer];
+            if (++i % ENCODER_BENCHMARK_BATCH == 0 || i == notes.count) {
+                AirTurnEventBufferAppendLiteral(&buffer, "]");
+                encoderBytes += AirTurnEventBufferCopyString(&buffer).length;
+                buffer.length = 0;
+            }
+        }
+    }
+    uint64_t encoderNs = NanosecondsSince(start);
+    AirTurnEventBufferFree(&buffer);
+
+    double legacyPerEvent = (double)legacyNs / notes.count;
+    double encoderPerEvent = (double)encoderNs / notes.count;
+
+    NSLog(@"AirTurnEncoderBenchmark: %lu events, legacy %.0f ns/event (%lu chars), encoder %.0f ns/event (%lu chars), %.1fx",
+          (unsigned long)notes.count, legacyPerEvent, (unsigned long)legacyBytes, encoderPerEvent, (unsigned long)encoderBytes, legacyPerEvent / encoderPerEvent);
+
+    return @{
+             @"count": @(notes.count),
+             @"legacyNsPerEvent": @(legacyPerEvent),
+             @"encoderNsPerEvent": @(encoderPerEvent),
+             @"speedup": @(legacyPerEvent / encoderPerEvent)
+             };
+}
+
+@end
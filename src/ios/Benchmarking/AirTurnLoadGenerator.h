@@ -0,0 +1,60 @@
+//
+//  AirTurnLoadGenerator.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+
+#define LOAD_GENERATOR_DEFAULT_DURATION 2.0 // Seconds each rate is driven for
+
+@class AirTurn;
+@class AirTurnSessionReplayer;
+
+/**
+ Drives a private `AirTurn` plugin instance with synthetic pedal press, connection state and battery notifications at fixed rates, and measures what comes out of its bridge.
+
+ The plugin instance is wired to a stub command delegate that counts delivered batches and events instead of talking to a WebView, and observes a private notification center, so the page and the real plugin never see the load.
+ */
+@interface AirTurnLoadGenerator : NSObject
+
+/**
+ Run the load and log the results. Must not be called on the main thread.
+
+ @param rates Events per second to drive, each run in turn. Default 1, 100, 1000 and 10000.
+ @param duration Seconds to drive each rate for, 0 for the default
+ @return Results with the key `runs`, one entry per rate with the keys `rate`, `posted`, `delivered`, `superseded` (status events replaced by a newer one in the event queue's latest-only lane, by design), `dropped` (events lost otherwise, 0 unless something is wrong), `batches`, `throughput` (delivered events per second) and `cpuNsPerEvent` (process CPU time per posted event)
+ */
++ (nonnull NSDictionary *)runWithRates:(nullable NSArray<NSNumber *> *)rates duration:(NSTimeInterval)duration;
+
+/**
+ Replay a recorded session into the private plugin instead of uniform load, and log the results. Must not be called on the main thread.
+
+ @param session The session to replay
+ @param speed How many times faster than recorded to replay, 0 for as fast as possible
+ @return Results with the key `runs`, one entry with the keys of a rate run plus `speed` and `duration` instead of `rate`
+ */
++ (nonnull NSDictionary *)runSession:(nonnull AirTurnSessionReplayer *)session speed:(double)speed;
+
+/**
+ A fresh plugin instance of the kind the load runs use, for other benchmarks: it observes a private notification center, and its batches go to a stub command delegate instead of the page, so what it processes never reaches the page's listeners or the real plugin's statistics. Must not be called on the main thread.
+
+ @param eventNames The event names to observe
+ @return The plugin, with its event stream open. It keeps its stub delegate alive.
+ */
++ (nonnull AirTurn *)privatePluginObservingEventNames:(nonnull NSArray<NSString *> *)eventNames;
+
+/**
+ As `privatePluginObservingEventNames:`, with the plugin initialised from `settings` as if they came from config.xml.
+
+ @param eventNames The event names to observe
+ @param settings Preferences by lowercased name, e.g. `@{ @"airturnprocesseventsonmainqueue": @"true" }`
+ @return The plugin, with its event stream open. It keeps its stub delegate alive.
+ */
++ (nonnull AirTurn *)privatePluginObservingEventNames:(nonnull NSArray<NSString *> *)eventNames settings:(nonnull NSDictionary *)settings;
+
+/**
+ Stop a private plugin observing. Must not be called on the main thread.
+ */
++ (void)tearDownPlugin:(nonnull AirTurn *)plugin eventNames:(nonnull NSArray<NSString *> *)eventNames;
+
+@end
@@ -0,0 +1,323 @@
+//
+//  AirTurnLoadGenerator.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnLoadGenerator.h"
+#import "AirTurn.h"
+#import "AirTurnLatencyStats.h"
+#import "AirTurnSessionReplayer.h"
+#include <sys/resource.h>
+#import <objc/runtime.h>
+
+static NSString * const LoadCallbackId = @"AirTurnLoadGenerator";
+static NSString * const StatsCallbackId = @"AirTurnLoadGeneratorStats";
+
+// the command delegate property is weak, so a private plugin holds on to its stub here
+static const void * const StubDelegateKey = &StubDelegateKey;
+
+static uint64_t ProcessCPUTimeNs(void)
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (uint64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * NSEC_PER_SEC
+         + (uint64_t)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * NSEC_PER_USEC;
+}
+
+/**
+ * Stands in for the WebView: counts what the plugin would have sent to it.
+**/
+@interface AirTurnLoadCommandDelegate : NSObject <CDVCommandDelegate>
+
+@property (nonatomic, assign) NSUInteger batches;
+@property (nonatomic, assign) NSUInteger events;
+// the last getQueueStats result
+@property (nonatomic, strong) NSDictionary *queueStats;
+// what config.xml would give the plugin, keys lowercased
+@property (nonatomic, copy) NSDictionary *preferences;
+
+@end
+
+@implementation AirTurnLoadCommandDelegate
+
+- (NSDictionary *)settings
+{
+    return self.preferences ?: @{};
+}
+
+/**
+ * Events in a `[[eventId,{...}],...]` batch. The synthetic payloads never
+ * contain nested arrays, so every element but the first follows a `],[`.
+**/
+static NSUInteger EventsInBatch(NSString *batch)
+{
+    NSUInteger count = batch.length > 2 ? 1 : 0;
+    NSRange range = NSMakeRange(0, batch.length);
+    while ((range = [batch rangeOfString:@"],[" options:NSLiteralSearch range:range]).location != NSNotFound) {
+        count++;
+        range = NSMakeRange(NSMaxRange(range), batch.length - NSMaxRange(range));
+    }
+    return count;
+}
+
+- (void)sendPluginResult:(CDVPluginResult *)result callbackId:(NSString *)callbackId
+{
+    if ([callbackId isEqualToString:LoadCallbackId] && [result.message isKindOfClass:[NSString class]]) {
+        NSUInteger events = EventsInBatch(result.message);
+        @synchronized(self) {
+            self.batches++;
+            self.events += events;
+        }
+    } else if ([callbackId isEqualToString:StatsCallbackId] && [result.message isKindOfClass:[NSDictionary class]]) {
+        @synchronized(self) {
+            self.queueStats = result.message;
+        }
+    }
+}
+
+- (void)evalJs:(NSString *)js
+{
+}
+
+- (void)evalJs:(NSString *)js scheduledOnRunLoop:(BOOL)scheduledOnRunLoop
+{
+}
+
+- (void)runInBackground:(void (^)(void))block
+{
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), block);
+}
+
+- (id)getCommandInstance:(NSString *)pluginName
+{
+    return nil;
+}
+
+- (NSString *)pathForResource:(NSString *)resourcepath
+{
+    return nil;
+}
+
+- (NSString *)userAgent
+{
+    return @"";
+}
+
+@end
+
+@implementation AirTurnLoadGenerator
+
+/**
+ * Mostly pedal presses, with a connection change every 50 events and a
+ * battery update every 100.
+**/
++ (NSArray<NSNotification *> *)notificationCycle
+{
+    NSMutableArray *notes = [NSMutableArray arrayWithCapacity:100];
+    for (NSUInteger i = 0; i < 100; i++) {
+        if (i == 49) {
+            [notes addObject:[NSNotification notificationWithName:AirTurnConnectionStateChangedNotification object:nil userInfo:@{ AirTurnConnectionStateKey: @(AirTurnConnectionStateConnected) }]];
+        } else if (i == 99) {
+            [notes addObject:[NSNotification notificationWithName:AirTurnDidUpdateBatteryLevelNotification object:nil userInfo:@{}]];
+        } else {
+            [notes addObject:[NSNotification notificationWithName:AirTurnPedalPressNotification object:nil userInfo:@{ AirTurnPortNumberKey: @(AirTurnPortMinimum + (i % 4)), AirTurnPortStateKey: @(AirTurnPortStateDown), AirTurnPedalRepeatCount: @0 }]];
+        }
+    }
+    return notes;
+}
+
+/**
+ * A fresh plugin wired to the stub delegate and a private notification
+ * center, with its event stream open and listening for `eventNames`.
+**/
++ (AirTurn *)pluginWithDelegate:(AirTurnLoadCommandDelegate *)delegate eventNames:(NSArray<NSString *> *)eventNames
+{
+    __block AirTurn *plugin;
+    dispatch_sync(dispatch_get_main_queue(), ^{
+        plugin = [[AirTurn alloc] initWithWebViewEngine:nil];
+        plugin.commandDelegate = delegate;
+        plugin.notificationCenter = [[NSNotificationCenter alloc] init];
+        [plugin pluginInitialize];
+
+        CDVInvokedUrlCommand *open = [[CDVInvokedUrlCommand alloc] initWithArguments:@[] callbackId:LoadCallbackId className:@"AirTurn" methodName:@"openEventStream"];
+        [plugin openEventStream:open];
+
+        for (NSString *eventName in eventNames) {
+            [plugin observeEventName:eventName];
+        }
+    });
+    return plugin;
+}
+
++ (AirTurn *)privatePluginObservingEventNames:(NSArray<NSString *> *)eventNames
+{
+    return [self privatePluginObservingEventNames:eventNames settings:@{}];
+}
+
++ (AirTurn *)privatePluginObservingEventNames:(NSArray<NSString *> *)eventNames settings:(NSDictionary *)settings
+{
+    AirTurnLoadCommandDelegate *delegate = [[AirTurnLoadCommandDelegate alloc] init];
+    delegate.preferences = settings;
+    AirTurn *plugin = [self pluginWithDelegate:delegate eventNames:eventNames];
+    objc_setAssociatedObject(plugin, StubDelegateKey, delegate, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    return plugin;
+}
+
++ (void)tearDownPlugin:(AirTurn *)plugin eventNames:(NSArray<NSString *> *)eventNames
+{
+    dispatch_sync(dispatch_get_main_queue(), ^{
+        for (NSString *eventName in eventNames) {
+            [plugin stopObservingEventName:eventName];
+        }
+    });
+}
+
+/**
+ * Status events the plugin's event queue has superseded so far.
+**/
++ (unsigned long long)supersededByPlugin:(AirTurn *)plugin delegate:(AirTurnLoadCommandDelegate *)delegate
+{
+    dispatch_sync(dispatch_get_main_queue(), ^{
+        CDVInvokedUrlCommand *stats = [[CDVInvokedUrlCommand alloc] initWithArguments:@[] callbackId:StatsCallbackId className:@"AirTurn" methodName:@"getQueueStats"];
+        [plugin getQueueStats:stats];
+    });
+    // the statistics are read on the processing queue and answered from main
+    dispatch_sync(plugin.processingQueue, ^{});
+    dispatch_sync(dispatch_get_main_queue(), ^{});
+
+    @synchronized(delegate) {
+        return [delegate.queueStats[@"superseded"] unsignedLongLongValue];
+    }
+}
+
+/**
+ * Runs `post`, which returns how many notifications it posted, then waits
+ * for the pipeline to drain and compares what came out.
+**/
++ (NSDictionary *)measurePlugin:(AirTurn *)plugin delegate:(AirTurnLoadCommandDelegate *)delegate posting:(NSUInteger (^)(NSNotificationCenter *center))post
+{
+    @synchronized(delegate) {
+        delegate.batches = 0;
+        delegate.events = 0;
+    }
+    unsigned long long supersededBefore = [self supersededByPlugin:plugin delegate:delegate];
+
+    uint64_t cpuBefore = ProcessCPUTimeNs();
+    uint64_t start = AirTurnLatencyNow();
+
+    NSUInteger posted = post(plugin.notificationCenter);
+
+    // let the observers finish, send what is still waiting for its batch window, and let the hand-off finish
+    [plugin.notificationQueue waitUntilAllOperationsAreFinished];
+    dispatch_sync(plugin.processingQueue, ^{
+        [plugin flushEvents];
+    });
+    dispatch_sync(dispatch_get_main_queue(), ^{});
+
+    uint64_t wall = AirTurnLatencyNow() - start;
+    uint64_t cpu = ProcessCPUTimeNs() - cpuBefore;
+
+    NSUInteger delivered, batches;
+    @synchronized(delegate) {
+        delivered = delegate.events;
+        batches = delegate.batches;
+    }
+    NSUInteger superseded = (NSUInteger)([self supersededByPlugin:plugin delegate:delegate] - supersededBefore);
+
+    return @{
+             @"posted": @(posted),
+             @"delivered": @(delivered),
+             @"superseded": @(superseded),
+             @"dropped": @(posted > delivered + superseded ? posted - delivered - superseded : 0),
+             @"batches": @(batches),
+             @"throughput": @(delivered / ((double)wall / NSEC_PER_SEC)),
+             @"cpuNsPerEvent": @(posted ? (double)cpu / posted : 0)
+             };
+}
+
++ (NSDictionary *)runRate:(double)rate duration:(NSTimeInterval)duration plugin:(AirTurn *)plugin delegate:(AirTurnLoadCommandDelegate *)delegate notes:(NSArray<NSNotification *> *)notes
+{
+    NSUInteger total = (NSUInteger)MAX(1, rate * duration);
+
+    NSMutableDictionary *run = [[self measurePlugin:plugin delegate:delegate posting:^NSUInteger(NSNotificationCenter *center) {
+        NSUInteger posted = 0;
+        uint64_t start = AirTurnLatencyNow();
+
+        // post whatever the schedule says is due, then sleep for a millisecond
+        while (posted < total) {
+            uint64_t elapsed = AirTurnLatencyNow() - start;
+            NSUInteger due = MIN(total, (NSUInteger)(rate * elapsed / NSEC_PER_SEC) + 1);
+            @autoreleasepool {
+                for (; posted < due; posted++) {
+                    [center postNotification:notes[posted % notes.count]];
+                }
+            }
+            if (posted < total) {
+                usleep(1000);
+            }
+        }
+        return posted;
+    }] mutableCopy];
+
+    run[@"rate"] = @(rate);
+    return run;
+}
+
++ (NSDictionary *)runWithRates:(NSArray<NSNumber *> *)rates duration:(NSTimeInterval)duration
+{
+    NSAssert(![NSThread isMainThread], @"AirTurnLoadGenerator must not run on the main thread");
+
+    if (rates.count == 0) {
+        rates = @[ @1, @100, @1000, @10000 ];
+    }
+    if (duration <= 0) {
+        duration = LOAD_GENERATOR_DEFAULT_DURATION;
+    }
+
+    NSArray<NSNotification *> *notes = [self notificationCycle];
+    AirTurnLoadCommandDelegate *delegate = [[AirTurnLoadCommandDelegate alloc] init];
+    NSArray<NSString *> *eventNames = [[NSSet setWithArray:[notes valueForKey:@"name"]] allObjects];
+    AirTurn *plugin = [self pluginWithDelegate:delegate eventNames:eventNames];
+
+    NSMutableArray *runs = [NSMutableArray arrayWithCapacity:rates.count];
+    for (NSNumber *rate in rates) {
+        if ([rate doubleValue] <= 0) {
+            continue;
+        }
+        NSDictionary *run = [self runRate:[rate doubleValue] duration:duration plugin:plugin delegate:delegate notes:notes];
+        NSLog(@"AirTurnLoadGenerator: %.0f events/s, posted %@, delivered %@ in %@ batches, superseded %@, dropped %@, %.0f events/s out, %.0f ns CPU/event",
+              [rate doubleValue], run[@"posted"], run[@"delivered"], run[@"batches"], run[@"superseded"], run[@"dropped"], [run[@"throughput"] doubleValue], [run[@"cpuNsPerEvent"] doubleValue]);
+        [runs addObject:run];
+    }
+
+    [self tearDownPlugin:plugin eventNames:eventNames];
+
+    return @{ @"runs": runs };
+}
+
++ (NSDictionary *)runSession:(AirTurnSessionReplayer *)session speed:(double)speed
+{
+    NSAssert(![NSThread isMainThread], @"AirTurnLoadGenerator must not run on the main thread");
+
+    AirTurnLoadCommandDelegate *delegate = [[AirTurnLoadCommandDelegate alloc] init];
+    NSArray<NSString *> *eventNames = [[NSSet setWithArray:[session.notifications valueForKey:@"name"]] allObjects];
+    AirTurn *plugin = [self pluginWithDelegate:delegate eventNames:eventNames];
+
+    NSMutableDictionary *run = [[self measurePlugin:plugin delegate:delegate posting:^NSUInteger(NSNotificationCenter *center) {
+        [session replayToCenter:center speed:speed];
+        return session.notifications.count;
+    }] mutableCopy];
+    run[@"speed"] = @(speed);
+    run[@"duration"] = @(session.duration);
+
+    NSLog(@"AirTurnLoadGenerator: session of %.1f s at %.0fx, posted %@, delivered %@ in %@ batches, superseded %@, dropped %@, %.0f events/s out, %.0f ns CPU/event",
+          session.duration, speed, run[@"posted"], run[@"delivered"], run[@"batches"], run[@"superseded"], run[@"dropped"], [run[@"throughput"] doubleValue], [run[@"cpuNsPerEvent"] doubleValue]);
+
+    [self tearDownPlugin:plugin eventNames:eventNames];
+
+    return @{ @"runs": @[ run ] };
+}
+
+@end
@@ -0,0 +1,24 @@
+//
+//  AirTurnProcessingBenchmark.h
+//  Cordova Airturn Plugin
+//
+
+#import <Foundation/Foundation.h>
+
+#define PROCESSING_BENCHMARK_COUNT 10000 // Notifications posted per mode
+
+/**
+ Measures how much main thread CPU time the plugin spends per notification with processing on the main queue and on the background processing queue.
+ */
+@interface AirTurnProcessingBenchmark : NSObject
+
+/**
+ Run the benchmark and log the results. Must not be called on the main thread.
+
+ The notifications go to a private plugin instance per mode (see `+[AirTurnLoadGenerator privatePluginObservingEventNames:settings:]`) on its own notification center, so the page's listeners, the real plugin's latency statistics and its processing mode are untouched.
+
+ @return Results with the keys `count`, `mainQueueNsPerEvent` and `backgroundNsPerEvent`
+ */
++ (nonnull NSDictionary *)run;
+
+@end
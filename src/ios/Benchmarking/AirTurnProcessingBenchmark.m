@@ -0,0 +1,80 @@
+//
+//  AirTurnProcessingBenchmark.m
+//  Cordova Airturn Plugin
+//
+
+#import "AirTurnProcessingBenchmark.h"
+#import "AirTurn.h"
+#import "AirTurnLoadGenerator.h"
+#include <mach/mach.h>
+#include <pthread.h>
+
+static NSString * const BenchmarkEventName = @"AirTurnProcessingBenchmarkNotification";
+
+/**
+ * CPU time consumed by the main thread so far. This includes anything else
+ * the main thread does while the benchmark runs, so run it on an idle screen.
+**/
+static uint64_t MainThreadCPUTimeNs(void)
+{
+    mach_port_t thread = pthread_mach_thread_np(pthread_main_thread_np());
+    thread_basic_info_data_t info;
+    mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+    if (thread_info(thread, THREAD_BASIC_INFO, (thread_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return (uint64_t)(info.user_time.seconds + info.system_time.seconds) * NSEC_PER_SEC
+         + (uint64_t)(info.user_time.microseconds + info.system_time.microseconds) * NSEC_PER_USEC;
+}
+
+@implementation AirTurnProcessingBenchmark
+
++ (double)mainThreadNsPerEventOnMainQueue:(BOOL)onMainQueue
+{
+    // the mode is fixed when the plugin's processing queue is created, so each mode gets its own plugin
+    NSDictionary *settings = @{ @"airturnprocesseventsonmainqueue": onMainQueue ? @"true" : @"false" };
+    AirTurn *plugin = [AirTurnLoadGenerator privatePluginObservingEventNames:@[ BenchmarkEventName ] settings:settings];
+
+    NSDictionary *userInfo = @{ @"AirTurnPortNumberKey": @1 };
+    NSNotificationCenter *nc = plugin.notificationCenter;
+
+    uint64_t before = MainThreadCPUTimeNs();
+
+    @autoreleasepool {
+        for (NSUInteger i = 0; i < PROCESSING_BENCHMARK_COUNT; i++) {
+            [nc postNotificationName:BenchmarkEventName object:nil userInfo:userInfo];
+        }
+    }
+
+    // let every observer run, flush the last coalescing window and let the hand-off reach main
+    [plugin.notificationQueue waitUntilAllOperationsAreFinished];
+    dispatch_sync(plugin.processingQueue, ^{
+        [plugin flushEvents];
+    });
+    dispatch_sync(dispatch_get_main_queue(), ^{});
+
+    uint64_t after = MainThreadCPUTimeNs();
+
+    [AirTurnLoadGenerator tearDownPlugin:plugin eventNames:@[ BenchmarkEventName ]];
+
+    return (double)(after - before) / PROCESSING_BENCHMARK_COUNT;
+}
+
++ (NSDictionary *)run
+{
+    NSAssert(![NSThread isMainThread], @"AirTurnProcessingBenchmark must not run on the main thread");
+
+    double mainQueue = [self mainThreadNsPerEventOnMainQueue:YES];
+    double background = [self mainThreadNsPerEventOnMainQueue:NO];
+
+    NSLog(@"AirTurnProcessingBenchmark: %d events, main thread time %.0f ns/event on main queue, %.0f ns/event on processing queue",
+          PROCESSING_BENCHMARK_COUNT, mainQueue, background);
+
+    return @{
+             @"count": @(PROCESSING_BENCHMARK_COUNT),
+             @"mainQueueNsPerEvent": @(mainQueue),
+             @"backgroundNsPerEvent": @(background)
+             };
+}
+
+@end
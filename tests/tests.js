@@ -0,0 +1,107 @@
+/*
+ * Run by cordova-plugin-test-framework, e.g. on the iOS simulator with
+ * `npm test`. Nothing here needs an AirTurn: the native side is driven with
+ * synthetic notifications on a private notification center.
+ */
+
+exports.defineAutoTests = function () {
+
+    describe("load harness", function () {
+
+        it("delivers every synthetic event", function (done) {
+            window.airturn.runBenchmark("load", function (r) {
+                expect(r.runs.length).toBe(2);
+                r.runs.forEach(function (run) {
+                    // status events may be superseded by newer ones, nothing else may go missing
+                    expect(run.dropped).toBe(0);
+                    expect(run.delivered + run.superseded).toBe(run.posted);
+                    expect(run.batches).toBeGreaterThan(0);
+                    expect(run.batches).toBeLessThan(run.posted + 1);
+                });
+                done();
+            }, function (err) {
+                fail(err);
+                done();
+            }, { rates: [100, 1000], duration: 1 });
+        }, 30000);
+    });
+
+    describe("event IDs", function () {
+
+        // names the README tells pages to listen for, by their string values
+        var documentedNames = [
+            "AirTurnPedalPressNotification",
+            "AirTurnGesture",
+            "AirTurnPedalRepeat",
+            "AirTurnAnalogFrame",
+            "AirTurnReady",
+            "AirTurnStatus"
+        ];
+
+        function subscribe(name, success) {
+            cordova.exec(function (id) {
+                // subscriptions are counted natively, so this leaves the page's own alone
+                cordova.exec(function () {}, function () {}, "airturn", "removeEventListener", [name]);
+                success(id);
+            }, function (err) {
+                fail(name + ": " + err);
+                success(null);
+            }, "airturn", "addEventListener", [name]);
+        }
+
+        it("subscribes every name in the event ID table under its fixed ID", function (done) {
+            window.airturn.getEventIds(function (table) {
+                var names = Object.keys(table);
+                documentedNames.forEach(function (name) {
+                    expect(names).toContain(name);
+                });
+
+                var distinct = {};
+                names.forEach(function (name) {
+                    distinct[table[name]] = true;
+                });
+                expect(Object.keys(distinct).length).toBe(names.length);
+
+                var pending = names.length;
+                names.forEach(function (name) {
+                    subscribe(name, function (id) {
+                        expect(id).toBe(table[name], name);
+                        if (--pending === 0) {
+                            done();
+                        }
+                    });
+                });
+            }, function (err) {
+                fail(err);
+                done();
+            });
+        });
+
+        it("sends names without an ID by name", function (done) {
+            subscribe("AirTurnTestUnknownNotification", function (id) {
+                expect(id).toBe("AirTurnTestUnknownNotification");
+                done();
+            });
+        });
+    });
+
+    describe("settings prewarm", function () {
+
+        it("leaves the central, view manager and user defaults as they were", function (done) {
+            window.airturn.initAirTurn(function () {
+                window.airturn.runBenchmark("settings", function (r) {
+                    expect(r.unchanged).toBe(true);
+                    // a UI whose setup changed anything is never kept
+                    expect(r.prewarmed).toBe(r.changed.length === 0);
+                    done();
+                }, function (err) {
+                    fail(err);
+                    done();
+                });
+            }, function (err) {
+                fail(err);
+                done();
+            });
+        }, 10000);
+    });
+};
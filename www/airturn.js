@@ -4,7 +4,43 @@ var channel = require('cordova/channel');
 
 module.exports = {
 
+    // listeners that get a DOM Event, the default
     _channels: {},
+    // listeners that asked for a plain object
+    _handlers: {},
+    // listeners that asked for a reused event object
+    _pooledHandlers: {},
+    _pool: {},
+    _poolBusy: {},
+    // events arrive by numeric ID, learnt per event name when subscribing natively; names without one arrive by name
+    _ids: {},
+    _names: [],
+    _byId: [],
+    _pooledById: [],
+    _channelsById: [],
+    _poolById: [],
+    _poolBusyById: [],
+    _streamOpen: false,
+    _latencyTracking: false,
+    _latencySamples: null,
+    _deliveryProbe: null,
+    _batchesReceived: 0,
+    _ackPending: false,
+    _textEditing: false,
+    _inflight: {},
+    _cache: {},
+    _cacheGeneration: 0,
+    _statusListening: false,
+    // how long a status result is reused for when no push has updated it, in milliseconds
+    cacheTTL: 1000,
+    // kept current by the plugin once the event stream is open, read it synchronously
+    state: {
+        connected: false,
+        centralState: 0,
+        version: 0,
+        peripherals: {}
+    },
+    _trackingFocus: false,
     createEvent: function (type, data) {
         var event = document.createEvent('Event');
         event.initEvent(type, false, false);
@@ -18,10 +54,14 @@ module.exports = {
         return event;
     },
     initAirTurn: function (success, error) {
+        this.openEventStream();
         exec(success, error, "airturn", "initAirTurn", null);
     },
+    getStartupProfile: function (success, error) {
+        exec(success, error, "airturn", "getStartupProfile", null);
+    },
     makeActive: function (success, error) {
-        exec(success, error, "airturn", "makeActive", null);
+        return this._settle(this._query("makeActive", null, false), success, error);
     },
 
     setting: function (success, error) {
@@ -29,48 +69,513 @@ module.exports = {
     },
 
     isConnected: function (success, error) {
-        exec(success, error, "airturn", "isConnected", null);
+        return this._settle(this._query("isConnected", null, true), success, error);
+    },
+
+    getInfo: function (success, error, identifier) {
+        return this._settle(this._query("getInfo", identifier ? [identifier] : null, true), success, error);
+    },
+
+    // concurrent identical calls share one native call; cacheable results are reused until they expire or a push changes them
+    _query: function (action, args, cacheable) {
+        var key = action + ":" + JSON.stringify(args || []);
+        if (cacheable) {
+            this._listenForStatus();
+            var hit = this._cache[key];
+            if (hit && Date.now() - hit.at < this.cacheTTL) {
+                return Promise.resolve(hit.value);
+            }
+        }
+        var pending = this._inflight[key];
+        if (pending) {
+            return pending;
+        }
+        var me = this;
+        var generation = this._cacheGeneration;
+        pending = new Promise(function (resolve, reject) {
+            exec(resolve, reject, "airturn", action, args);
+        });
+        this._inflight[key] = pending;
+        pending.then(function (value) {
+            if (me._inflight[key] === pending) {
+                delete me._inflight[key];
+            }
+            // a push while the call was in flight makes its result stale
+            if (cacheable && generation === me._cacheGeneration) {
+                me._cache[key] = { value: value, at: Date.now() };
+            }
+        }, function () {
+            if (me._inflight[key] === pending) {
+                delete me._inflight[key];
+            }
+        });
+        return pending;
+    },
+
+    // callbacks when given, as before, otherwise the promise
+    _settle: function (promise, success, error) {
+        if (!success && !error) {
+            return promise;
+        }
+        promise.then(success, error);
+    },
+
+    _listenForStatus: function () {
+        if (this._statusListening) {
+            return;
+        }
+        this._statusListening = true;
+        var me = this;
+        this.addAirTurnEventListener("AirTurnStatus", function (e) {
+            me._applyStatus(e);
+            me._cacheGeneration++;
+            me._cache = {};
+            me._inflight = {};
+            me._cache["isConnected:[]"] = { value: e.connected, at: Date.now() };
+        }, { plain: true });
+    },
+
+    _applyStatus: function (e) {
+        var state = this.state;
+        var i;
+        state.connected = e.connected;
+        state.centralState = e.centralState;
+        if (e.full) {
+            state.peripherals = {};
+        }
+        for (i = 0; i < e.peripherals.length; i++) {
+            state.peripherals[e.peripherals[i].identifier] = e.peripherals[i];
+        }
+        for (i = 0; i < e.removed.length; i++) {
+            delete state.peripherals[e.removed[i]];
+        }
+        state.version = e.version;
     },
 
-    getInfo: function (success, error) {
-        exec(success, error, "airturn", "getInfo", null);
+    getSnapshot: function (sinceVersion, success, error) {
+        exec(success, error, "airturn", "getSnapshot", [sinceVersion || 0]);
     },
 
     killApp: function (success, error) {
         exec(success, error, "airturn", "killApp", null);
     },
 
+    setEventCoalescing: function (interval, success, error) {
+        exec(success, error, "airturn", "setEventCoalescing", [interval]);
+    },
+
+    setRepeatCoalescing: function (interval, success, error) {
+        exec(success, error, "airturn", "setRepeatCoalescing", [interval]);
+    },
+
     fireEvent: function (type, data) {
-        var event = this.createEvent(type, data);
-        if (event && (event.type in this._channels)) {
-            this._channels[event.type].fire(event);
+        this._dispatch(type, this._handlers[type], this._pooledHandlers[type], this._channels[type], data, this._pool, this._poolBusy, type);
+    },
+
+    _fireById: function (id, data) {
+        var type = this._names[id];
+        if (type !== undefined) {
+            this._dispatch(type, this._byId[id], this._pooledById[id], this._channelsById[id], data, this._poolById, this._poolBusyById, id);
+        }
+    },
+
+    _dispatch: function (type, handlers, pooledHandlers, eventChannel, data, pool, poolBusy, key) {
+        var i, k;
+        if (handlers && handlers.length) {
+            // a new object per event, which listeners may keep
+            var fresh = { type: type };
+            for (k in data) {
+                fresh[k] = data[k];
+            }
+            for (i = 0; i < handlers.length; i++) {
+                handlers[i](fresh);
+            }
+        }
+        if (pooledHandlers && pooledHandlers.length) {
+            // reuse one plain object per type; only a re-entrant fire of the same type allocates
+            var pooled = !poolBusy[key];
+            var event = pooled ? (pool[key] || (pool[key] = { type: type })) : { type: type };
+            for (k in event) {
+                if (k !== "type" && !(data && k in data)) {
+                    event[k] = undefined;
+                }
+            }
+            for (k in data) {
+                event[k] = data[k];
+            }
+            if (pooled) {
+                poolBusy[key] = true;
+            }
+            try {
+                for (i = 0; i < pooledHandlers.length; i++) {
+                    pooledHandlers[i](event);
+                }
+            } finally {
+                if (pooled) {
+                    poolBusy[key] = false;
+                }
+            }
+        }
+        if (eventChannel) {
+            eventChannel.fire(this.createEvent(type, data));
+        }
+    },
+
+    _index: function (eventname) {
+        var id = this._ids[eventname];
+        if (id !== undefined) {
+            this._names[id] = eventname;
+            this._byId[id] = this._handlers[eventname];
+            this._pooledById[id] = this._pooledHandlers[eventname];
+            this._channelsById[id] = this._channels[eventname];
+        }
+    },
+
+    setProcessingMode: function (mode, success, error) {
+        exec(success, error, "airturn", "setProcessingMode", [mode]);
+    },
+
+    startAnalogStream: function (options, success, error) {
+        exec(success, error, "airturn", "startAnalogStream", [options || {}]);
+    },
+
+    stopAnalogStream: function (success, error) {
+        exec(success, error, "airturn", "stopAnalogStream", null);
+    },
+
+    startGestures: function (options, success, error) {
+        exec(success, error, "airturn", "startGestures", [options || {}]);
+    },
+
+    stopGestures: function (success, error) {
+        exec(success, error, "airturn", "stopGestures", null);
+    },
+
+    startResponderWatchdog: function (options, success, error) {
+        options = options || {};
+        if (options.trackTextEditing !== false) {
+            this._trackFocus();
+        }
+        exec(success, error, "airturn", "startResponderWatchdog", [options]);
+    },
+
+    stopResponderWatchdog: function (success, error) {
+        exec(success, error, "airturn", "stopResponderWatchdog", null);
+    },
+
+    getResponderWatchdogStats: function (success, error) {
+        exec(success, error, "airturn", "getResponderWatchdogStats", null);
+    },
+
+    setTextEditing: function (editing) {
+        editing = !!editing;
+        if (editing === this._textEditing) {
+            return;
+        }
+        this._textEditing = editing;
+        exec(null, null, "airturn", "setTextEditing", [editing]);
+    },
+
+    _isEditable: function (el) {
+        if (!el || !el.tagName) {
+            return false;
+        }
+        if (el.isContentEditable || el.tagName === "TEXTAREA" || el.tagName === "SELECT") {
+            return true;
+        }
+        return el.tagName === "INPUT" && !/^(button|checkbox|radio|range|color|file|image|reset|submit|hidden)$/i.test(el.type);
+    },
+
+    _trackFocus: function () {
+        if (this._trackingFocus) {
+            return;
+        }
+        this._trackingFocus = true;
+        var me = this;
+        // only crosses the bridge when editing starts or ends, not on every focus change
+        document.addEventListener("focusin", function (e) {
+            me.setTextEditing(me._isEditable(e.target));
+        }, true);
+        document.addEventListener("focusout", function (e) {
+            me.setTextEditing(me._isEditable(e.relatedTarget));
+        }, true);
+    },
+
+    startRecording: function (name, success, error) {
+        exec(success, error, "airturn", "startRecording", name ? [name] : null);
+    },
+
+    stopRecording: function (success, error) {
+        exec(success, error, "airturn", "stopRecording", null);
+    },
+
+    replaySession: function (path, speed, success, error) {
+        exec(success, error, "airturn", "replaySession", [path, speed === undefined ? 1 : speed]);
+    },
+
+    runBenchmark: function (name, success, error, options) {
+        if (name === "delivery") {
+            this._runDeliveryBenchmark(success, error, options);
+            return;
+        }
+        exec(success, error, "airturn", "runBenchmark", [name, options || {}]);
+    },
+
+    _runDeliveryBenchmark: function (success, error, options) {
+        var me = this;
+        var samples = {};
+        me._deliveryProbe = function (path, batch, sentAt) {
+            var receivedAt = me._wallClock();
+            // parsed, as a delivered batch would be
+            if (typeof batch === "string") {
+                JSON.parse(batch);
+            }
+            (samples[path] = samples[path] || []).push(receivedAt - sentAt);
+        };
+        exec(function (message) {
+            if (typeof message === "string") {
+                var probe = JSON.parse(message);
+                me._deliveryProbe("callback", probe.events, probe.sentAt);
+                return;
+            }
+            me._deliveryProbe = null;
+            var paths = {};
+            for (var i = 0; i < message.paths.length; i++) {
+                paths[message.paths[i]] = me._summarizeSamples(samples[message.paths[i]] || [], message.count);
+            }
+            if (success) {
+                success({ count: message.count, interval: message.interval, paths: paths });
+            }
+        }, function (err) {
+            me._deliveryProbe = null;
+            if (error) {
+                error(err);
+            }
+        }, "airturn", "runBenchmark", ["delivery", options || {}]);
+    },
+
+    _summarizeSamples: function (samples, sent) {
+        var sorted = samples.slice().sort(function (a, b) { return a - b; });
+        var sum = 0;
+        for (var i = 0; i < sorted.length; i++) {
+            sum += sorted[i];
+        }
+        var at = function (q) {
+            return sorted.length ? sorted[Math.min(sorted.length - 1, Math.ceil(q * sorted.length) - 1)] : 0;
+        };
+        return {
+            received: sorted.length,
+            lost: Math.max(0, sent - sorted.length),
+            mean: sorted.length ? sum / sorted.length : 0,
+            p50: at(0.50),
+            p95: at(0.95),
+            max: sorted.length ? sorted[sorted.length - 1] : 0
+        };
+    },
+
+    setEventDelivery: function (mode, success, error) {
+        exec(success, error, "airturn", "setEventDelivery", [mode]);
+    },
+
+    // called by the plugin with callAsyncJavaScript in "direct" delivery, the batch is a JSON string.
+    // Only a batch that never got dispatched may fail the call, the plugin then resends it through the bridge
+    _deliver: function (batch, sentAt) {
+        var events = JSON.parse(batch);
+        try {
+            this.fireEvents(events, sentAt);
+        } catch (e) {
+            console.log("ERROR AirTurn listener: " + e);
+        }
+    },
+
+    openEventStream: function () {
+        if (this._streamOpen) {
+            return;
+        }
+        this._streamOpen = true;
+        this._listenForStatus();
+        var me = this;
+        exec(function (message) {
+            var batch = typeof message === "string" ? JSON.parse(message) : message;
+            if (batch.events) {
+                me.fireEvents(batch.events, batch.sentAt);
+            } else {
+                me.fireEvents(batch);
+            }
+        }, function (err) {
+            // events keep arriving through fireEvents evaluation
+            me._streamOpen = false;
+            console.log("ERROR openEventStream: " + err);
+        }, "airturn", "openEventStream", null);
+    },
+
+    closeEventStream: function (success, error) {
+        this._streamOpen = false;
+        exec(success, error, "airturn", "closeEventStream", null);
+    },
+
+    fireEvents: function (events, sentAt) {
+        var receivedAt = sentAt ? this._wallClock() : 0;
+        this._ackBatch();
+        for (var i = 0; i < events.length; i++) {
+            var key = events[i][0];
+            if (typeof key === "number") {
+                this._fireById(key, events[i][1]);
+            } else {
+                this.fireEvent(key, events[i][1]);
+            }
+        }
+        if (sentAt && this._latencyTracking) {
+            this._recordLatency(receivedAt - sentAt, this._wallClock() - receivedAt);
+        }
+    },
+
+    _ackBatch: function () {
+        var me = this;
+        me._batchesReceived++;
+        if (me._ackPending) {
+            return;
+        }
+        // one acknowledgement for every batch handled in this task, sent once the listeners have run
+        me._ackPending = true;
+        setTimeout(function () {
+            me._ackPending = false;
+            exec(null, null, "airturn", "ackEvents", [me._batchesReceived]);
+        }, 0);
+    },
+
+    getQueueStats: function (success, error) {
+        exec(success, error, "airturn", "getQueueStats", null);
+    },
+
+    _wallClock: function () {
+        if (window.performance && performance.timeOrigin) {
+            return performance.timeOrigin + performance.now();
+        }
+        return Date.now();
+    },
+
+    _recordLatency: function (bridge, dispatch) {
+        var me = this;
+        if (!me._latencySamples) {
+            // report at most once a second rather than crossing the bridge per batch
+            me._latencySamples = [[], []];
+            setTimeout(function () {
+                var samples = me._latencySamples;
+                me._latencySamples = null;
+                exec(null, null, "airturn", "reportLatency", samples);
+            }, 1000);
         }
+        me._latencySamples[0].push(bridge);
+        me._latencySamples[1].push(dispatch);
     },
 
-    addAirTurnEventListener: function (eventname, f) {
-        if (!(eventname in this._channels)) {
+    setLatencyTracking: function (enabled, success, error) {
+        this._latencyTracking = !!enabled;
+        exec(success, error, "airturn", "setLatencyTracking", [!!enabled]);
+    },
+
+    getLatencyStats: function (success, error) {
+        exec(success, error, "airturn", "getLatencyStats", null);
+    },
+
+    resetLatencyStats: function (success, error) {
+        exec(success, error, "airturn", "resetLatencyStats", null);
+    },
+
+    getCommandStats: function (success, error) {
+        exec(success, error, "airturn", "getCommandStats", null);
+    },
+
+    resetCommandStats: function (success, error) {
+        exec(success, error, "airturn", "resetCommandStats", null);
+    },
+
+    addAirTurnEventListener: function (eventname, f, options) {
+        this.openEventStream();
+        var first = this._listenerCount(eventname) === 0;
+        // a DOM Event unless the listener asks for a plain object; pooled objects are plain
+        var plain = options && (options.plain || options.pooled);
+        if (!plain) {
+            if (!(eventname in this._channels)) {
+                this._channels[eventname] = channel.create(eventname);
+            }
+            this._channels[eventname].subscribe(f);
+        } else {
+            var handlers = options && options.pooled ? this._pooledHandlers : this._handlers;
+            if ((handlers[eventname] || []).indexOf(f) < 0) {
+                // copy on write, so a listener removed during dispatch doesn't disturb the loop
+                handlers[eventname] = (handlers[eventname] || []).concat([f]);
+            }
+        }
+        this._index(eventname);
+        // the native side only observes an event while it has listeners here
+        if (first && this._listenerCount(eventname) > 0) {
             var me = this;
-            exec(function () {
-                me._channels[eventname] = channel.create(eventname);
-                me._channels[eventname].subscribe(f);
+            exec(function (id) {
+                if (typeof id === "number") {
+                    me._ids[eventname] = id;
+                    me._index(eventname);
+                }
             }, function (err) {
                 console.log("ERROR addEventListener: " + err)
             }, "airturn", "addEventListener", [eventname]);
         }
-        else {
-            this._channels[eventname].subscribe(f);
-        }
     },
 
     removeEventListener: function (eventname, f) {
+        if (this._listenerCount(eventname) === 0) {
+            return;
+        }
+        var lists = [this._handlers, this._pooledHandlers];
+        for (var l = 0; l < lists.length; l++) {
+            var handlers = lists[l][eventname];
+            var i = handlers ? handlers.indexOf(f) : -1;
+            if (i >= 0) {
+                handlers = handlers.slice();
+                handlers.splice(i, 1);
+                lists[l][eventname] = handlers;
+            }
+        }
         if (eventname in this._channels) {
-            var me = this;
-            exec(function () {
-                me._channels[eventname].unsubscribe(f);
-            }, function (err) {
+            this._channels[eventname].unsubscribe(f);
+        }
+        if (this._listenerCount(eventname) === 0) {
+            delete this._handlers[eventname];
+            delete this._pooledHandlers[eventname];
+            delete this._channels[eventname];
+            exec(null, function (err) {
                 console.log("ERROR removeEventListener: " + err)
             }, "airturn", "removeEventListener", [eventname]);
         }
+        this._index(eventname);
+    },
+
+    _listenerCount: function (eventname) {
+        var count = this._handlers[eventname] ? this._handlers[eventname].length : 0;
+        if (this._pooledHandlers[eventname]) {
+            count += this._pooledHandlers[eventname].length;
+        }
+        if (eventname in this._channels) {
+            count += this._channels[eventname].numHandlers;
+        }
+        return count;
+    },
+
+    listSubscriptions: function (success, error) {
+        var me = this;
+        exec(function (subscriptions) {
+            var listeners = {};
+            var names = Object.keys(me._handlers).concat(Object.keys(me._pooledHandlers), Object.keys(me._channels));
+            for (var i = 0; i < names.length; i++) {
+                listeners[names[i]] = me._listenerCount(names[i]);
+            }
+            success({ native: subscriptions, listeners: listeners });
+        }, error, "airturn", "listSubscriptions", null);
+    },
+
+    getEventIds: function (success, error) {
+        exec(success, error, "airturn", "getEventIds", null);
     }
 
 };